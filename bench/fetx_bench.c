@@ -0,0 +1,113 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../fetx_vector.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static double fetx_bench_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/* runs the input columns of a test vector through one runtime repeatedly and
+ * reports the time per row, the netlist is compiled outside the timed loop */
+
+int fetx_bench(const char *const netlist_pathname,
+               const char *const vector_pathname,
+               const unsigned long int repeats) {
+  struct fetx_netlist nl;
+  enum fetx_errs errs = fetx_netlist_from_file(&nl, netlist_pathname);
+  if (errs != FETX_ERR_NONE) {
+    printf("Failed to read netlist file %d\n", errs);
+    return -1;
+  }
+
+  struct fetx_vector vec;
+  errs = fetx_vector_from_file(&vec, vector_pathname);
+  if (errs != FETX_ERR_NONE) {
+    printf("Failed to read vector file %d\n", errs);
+    fetx_netlist_delete(nl);
+    return -1;
+  }
+
+  if (vec.width < nl.inputs_size) {
+    puts("Netlist io does not match vector");
+    fetx_netlist_delete(nl);
+    fetx_vector_delete(vec);
+    return -1;
+  }
+
+  struct fetx_vector input_vec = {
+      .values = vec.values, .width = nl.inputs_size, .length = vec.length};
+  struct fetx_vector output_vec = {.width = nl.outputs_size,
+                                   .length = vec.length};
+  if (fetx_vector_new(&output_vec) != 0) {
+    puts("Failed to allocate output vector");
+    fetx_netlist_delete(nl);
+    fetx_vector_delete(vec);
+    return -1;
+  }
+
+  struct fetx_io io;
+  if (fetx_io_init(&io, nl) != 0) {
+    puts("Failed to initialise runtime");
+    fetx_netlist_delete(nl);
+    fetx_vector_delete(vec);
+    fetx_vector_delete(output_vec);
+    return -1;
+  }
+
+  unsigned long int time = 0;
+  const double start = fetx_bench_seconds();
+  unsigned long int i = 0;
+  while (i < repeats) {
+    struct fetx_sim_res res;
+    errs = fetx_vector_sim_io(&res, output_vec, &io, input_vec, 0);
+    if (errs != FETX_ERR_NONE) {
+      printf("Simulation failed: %u\n", errs);
+      break;
+    }
+    time += res.time;
+    ++i;
+  }
+  const double elapsed = fetx_bench_seconds() - start;
+
+  if (errs == FETX_ERR_NONE) {
+    const double rows = (double)repeats * vec.length;
+    printf("%s: %lu rows, %lu resolve steps, %.3f s, %.1f ns/row\n",
+           netlist_pathname, (unsigned long int)rows, time, elapsed,
+           (rows > 0) ? (elapsed * 1e9) / rows : 0.0);
+  }
+
+  fetx_io_delete(io);
+  fetx_netlist_delete(nl);
+  fetx_vector_delete(vec);
+  fetx_vector_delete(output_vec);
+  return (errs == FETX_ERR_NONE) ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 4) {
+    puts("Incorrect number of arguments. fetx_bench takes 3 arguments\n"
+         "1: The netlist pathname\n2: The vector pathname, columns after the "
+         "inputs are ignored\n3: The number of times to run the vector");
+    return -1;
+  }
+  return fetx_bench(argv[1], argv[2], strtoul(argv[3], 0, 0));
+}
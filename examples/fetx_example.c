@@ -27,6 +27,7 @@ int fetx_example_inverter(void) {
   nl.fl.size = (sizeof(fets) / sizeof(fets[0]));
   nl.inputs_size = 3;
   nl.outputs_size = 1;
+  nl.supplies_size = 0;
 
   enum fetx_errs errs = fetx_netlist_new(&nl);
   if (errs != FETX_ERR_NONE) {
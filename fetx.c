@@ -15,6 +15,10 @@ limitations under the License.
  */
 
 #include "fetx.h"
+#include "fetx_wheel.h"
+#include "fetx_simd.h"
+
+#include <limits.h>
 
 static int fetx_check_post_multiply(const size_t q, const size_t a,
                                     const size_t b) {
@@ -37,6 +41,13 @@ void *fetx_calloc(const size_t nmemb, const size_t size) {
   return calloc(nmemb, size);
 }
 
+void *fetx_realloc(void *const ptr, const size_t nmemb, const size_t size) {
+  const size_t alloc_size = size * nmemb;
+  return (fetx_check_post_multiply(alloc_size, nmemb, size) != 0)
+             ? 0
+             : realloc(ptr, alloc_size);
+}
+
 void fetx_dealloc(void *const ptr) { free(ptr); }
 
 static inline void fetx_dealloc_two(void *const a, void *const b) {
@@ -78,105 +89,92 @@ void fetx_fetlist_assign_fet(struct fetx_fetlist *const fl,
   fl->fets[index] = fet;
 }
 
-void fetx_inter_delete(struct fetx_inter fxi) {
-  if (fxi.nodes != 0) {
-    if (fxi.nodes[0].connections != 0) {
-      fetx_dealloc(fxi.nodes[0].connections);
-    }
-    fetx_dealloc(fxi.nodes);
-  }
-  if (fxi.fets != 0) {
-    fetx_dealloc(fxi.fets);
-  }
+void fetx_graph_delete(struct fetx_graph graph) {
+  fetx_dealloc(graph.starts);
+  fetx_dealloc(graph.edges);
 }
 
-/* \nodes_size must be the id of the highest node + 1, not the number of nodes
- */
+/* built straight from the FET list in two passes, counting the edges of
+ * each node then filling them in. \nodes_size must be the id of the highest
+ * node + 1, not the number of nodes. */
 
-int fetx_inter_init_fns(struct fetx_inter *const fxi,
-                        const struct fetx_fetlist fl, size_t nodes_size) {
-  fxi->nodes_size = nodes_size;
-  fxi->fets_size = fl.size;
-  /* alloc memory for the counting of node connections */
-  struct nodes_alloc_sizes {
-    size_t connections;
-    size_t control;
-  };
-
-  struct nodes_alloc_sizes *alloc_sizes =
-      fetx_calloc(sizeof(*alloc_sizes), nodes_size);
-  if (alloc_sizes == 0) {
+int fetx_graph_init(struct fetx_graph *const graph,
+                    const struct fetx_fetlist fl, const size_t nodes_size) {
+  graph->nodes_size = nodes_size;
+  graph->edges = 0;
+  graph->starts = fetx_calloc(nodes_size + 1, sizeof(*graph->starts));
+  if (graph->starts == 0) {
     return -1;
   }
-
-  size_t n = 0;
-  while (n < fl.size) {
-    ++alloc_sizes[fl.fets[n].connections[0]].control;     /* gate */
-    ++alloc_sizes[fl.fets[n].connections[1]].connections; /* source */
-    ++alloc_sizes[fl.fets[n].connections[2]].connections; /* drain */
-    ++n;
-  }
-
-  /* alloc memory for the fetx struct */
-  fxi->nodes = fetx_alloc(sizeof(*fxi->nodes), nodes_size);
-  if (fxi->nodes == 0) {
-    fetx_dealloc(alloc_sizes);
+  size_t edges_size;
+  if (fetx_check_multiply(&edges_size, fl.size, 2) != 0) {
+    fetx_graph_delete(*graph);
     return -1;
   }
-
-  fxi->fets = fetx_alloc(sizeof(*fxi->fets), fl.size);
-  if (fxi->fets == 0) {
-    fetx_dealloc_two(alloc_sizes, fxi->nodes);
+  graph->edges = fetx_alloc(sizeof(*graph->edges), edges_size);
+  if ((graph->edges == 0) && (edges_size != 0)) {
+    fetx_graph_delete(*graph);
     return -1;
   }
 
-  if (fetx_check_multiply(&n, fl.size, 3) != 0) {
-    fetx_dealloc_two(alloc_sizes, fxi->nodes);
-    return -1;
-  }
-  struct fetx_inter_fet **concon = fetx_alloc(sizeof(*concon), n);
-  if (concon == 0) {
-    fetx_dealloc_two(alloc_sizes, fxi->nodes);
-    fetx_dealloc(fxi->fets);
-    return -1;
+  size_t n = 0;
+  while (n < fl.size) {
+    ++graph->starts[fl.fets[n].connections[1]]; /* source */
+    ++graph->starts[fl.fets[n].connections[2]]; /* drain */
+    ++n;
   }
-
+  /* each start becomes the end of the row, and steps back to the start as
+   * the row is filled */
+  size_t end = 0;
   n = 0;
   while (n < nodes_size) {
-    struct fetx_inter_node *node = fxi->nodes + n;
-    node->index = n;
-    node->connections = concon;
-    node->connections_limit = concon; /* not the final value */
-    concon += alloc_sizes[n].connections;
-    node->control = concon;
-    node->control_limit = concon;
-    concon += alloc_sizes[n].control;
+    end += graph->starts[n];
+    graph->starts[n] = end;
     ++n;
   }
-  fetx_dealloc(alloc_sizes);
+  graph->starts[nodes_size] = end;
+  /* filled from the back so each row lists its FETs in order */
+  n = fl.size;
+  while (n > 0) {
+    --n;
+    const size_t source = fl.fets[n].connections[1];
+    const size_t drain = fl.fets[n].connections[2];
+    struct fetx_graph_edge *edge = graph->edges + (--graph->starts[drain]);
+    edge->fet = n;
+    edge->node = source;
+    edge = graph->edges + (--graph->starts[source]);
+    edge->fet = n;
+    edge->node = drain;
+  }
+  return 0;
+}
 
-  n = 0;
-  while (n < fl.size) {
-    struct fetx_inter_fet *fet = fxi->fets + n;
-    fet->index = n;
-    fet->control = fxi->nodes + fl.fets[n].connections[0];
-    *fet->control->control_limit = fxi->fets + n;
-    ++fet->control->control_limit;
-    fet->connections[0] = fxi->nodes + fl.fets[n].connections[1];
-    *fet->connections[0]->connections_limit = fxi->fets + n;
-    ++fet->connections[0]->connections_limit;
-    fet->connections[1] = fxi->nodes + fl.fets[n].connections[2];
-    *fet->connections[1]->connections_limit = fxi->fets + n;
-    ++fet->connections[1]->connections_limit;
-    fet->type = fl.fets[n].type;
-    ++n;
+int fetx_graph_clone(struct fetx_graph *const graph,
+                     const struct fetx_graph src) {
+  const size_t edges_size = src.starts[src.nodes_size];
+  graph->nodes_size = src.nodes_size;
+  graph->starts = fetx_alloc(sizeof(*graph->starts), src.nodes_size + 1);
+  graph->edges = fetx_alloc(sizeof(*graph->edges), edges_size);
+  if ((graph->starts == 0) || ((graph->edges == 0) && (edges_size != 0))) {
+    fetx_graph_delete(*graph);
+    return -1;
+  }
+  size_t i = 0;
+  while (i <= src.nodes_size) {
+    graph->starts[i] = src.starts[i];
+    ++i;
+  }
+  i = 0;
+  while (i < edges_size) {
+    graph->edges[i] = src.edges[i];
+    ++i;
   }
   return 0;
 }
 
-int fetx_inter_init(struct fetx_inter *const fxi,
-                    const struct fetx_fetlist fl) {
-  return fetx_inter_init_fns(fxi, fl, fetx_fetlist_find_last_node(fl) + 1);
+size_t fetx_graph_bytes(const struct fetx_graph graph) {
+  return (sizeof(*graph.starts) * (graph.nodes_size + 1)) +
+         (sizeof(*graph.edges) * graph.starts[graph.nodes_size]);
 }
 
 void fetx_delete(struct fetx fx) {
@@ -186,60 +184,162 @@ void fetx_delete(struct fetx fx) {
   if (fx.fets != 0) {
     fetx_dealloc(fx.fets);
   }
+  if (fx.levels != 0) {
+    fetx_dealloc(fx.levels);
+  }
+  fetx_dealloc(fx.multiple);
+  fetx_dealloc(fx.multiple_positions);
+  fetx_dealloc(fx.wide_counts);
+  fetx_wheel_delete(fx.wheel);
+  fetx_cells_delete(fx.cells);
 }
 
-int fetx_init(struct fetx *const fx, const struct fetx_inter fxi) {
-  fx->nodes = fetx_alloc(sizeof(*fx->nodes), fxi.nodes_size);
-  if (fx->nodes == 0) {
+/* \nodes_size must be the id of the highest node + 1, not the number of
+ * nodes */
+
+int fetx_init(struct fetx *const fx, const struct fetx_fetlist fl,
+              const size_t nodes_size) {
+  fx->fets = 0;
+  fx->wheel = 0;
+  fx->cells = 0;
+  fx->time = 0;
+  fx->levels = 0;
+  fx->levels_size = 0;
+  fx->level = 0;
+  fx->multiple = fetx_alloc(sizeof(*fx->multiple), nodes_size);
+  fx->multiple_positions =
+      fetx_alloc(sizeof(*fx->multiple_positions), nodes_size);
+  fx->nodes = fetx_alloc(sizeof(*fx->nodes), nodes_size);
+  if ((fx->nodes == 0) || (fx->multiple == 0) ||
+      (fx->multiple_positions == 0)) {
+    fetx_dealloc(fx->nodes);
+    fetx_dealloc(fx->multiple);
+    fetx_dealloc(fx->multiple_positions);
     return -1;
   }
-  fx->nodes_limit = fx->nodes + fxi.nodes_size;
+  fx->nodes_limit = fx->nodes + nodes_size;
 
   struct fetx_node *node = fx->nodes;
   while (node < fx->nodes_limit) {
-    node->index = node - fx->nodes;
-    node->state_counts[FETX_LOW] = 0;
-    node->state_counts[FETX_HIGH] = 0;
-    node->state_counts[FETX_UNSTABLE_LOW] = 0;
-    node->state_counts[FETX_UNSTABLE_HIGH] = 0;
+    node->counts.narrow[FETX_LOW] = 0;
+    node->counts.narrow[FETX_HIGH] = 0;
+    node->counts.narrow[FETX_UNSTABLE_LOW] = 0;
+    node->counts.narrow[FETX_UNSTABLE_HIGH] = 0;
+    node->paths = 0;
+    node->state_mask = 0;
+    node->is_wide = 0;
     node->control = 0;
     node->is_input = 0;
+    node->is_supply = 0;
     node->flag = 0;
+    node->is_traced = 0;
+    node->is_trace_listed = 0;
     ++node;
   }
 
-  fx->fets = fetx_alloc(sizeof(*fx->fets), fxi.fets_size);
+  fx->fets = fetx_alloc(sizeof(*fx->fets), fl.size);
   if (fx->fets == 0) {
+    fetx_dealloc(fx->nodes);
+    fetx_dealloc(fx->multiple);
+    fetx_dealloc(fx->multiple_positions);
     return -1;
   }
-  fx->fets_limit = fx->fets + fxi.fets_size;
+  fx->fets_limit = fx->fets + fl.size;
 
   struct fetx_fet *fet = fx->fets;
   while (fet < fx->fets_limit) {
     size_t index = fet - fx->fets;
-    const struct fetx_inter_fet inter_fet = fxi.fets[index];
-    struct fetx_node *control_node = &fx->nodes[inter_fet.control->index];
+    struct fetx_node *control_node = &fx->nodes[fl.fets[index].connections[0]];
     fet->index = index;
     fet->control = control_node;
     fet->next_control = control_node->control;
     control_node->control = fet;
     fet->next_listed = 0;
     fet->state = FETX_UNSTABLE;
-    fet->type = inter_fet.type;
+    fet->type = fl.fets[index].type;
     fet->links = 0;
+    fet->level = 0;
     fet->is_listed = 0;
+    fet->cell = 0;
+    fet->delay = (fl.fets[index].delay != 0) ? fl.fets[index].delay : 1;
+    if ((fet->delay > 1) && (fx->wheel == 0)) {
+      /* unit delays alone are resolved a step at a time without it */
+      fx->wheel = fetx_wheel_new(fl.size, 1);
+      if (fx->wheel == 0) {
+        fetx_dealloc_two(fx->nodes, fx->fets);
+        fetx_dealloc_two(fx->multiple, fx->multiple_positions);
+        return -1;
+      }
+    }
     ++fet;
   }
 
   fx->fets_update = 0;
   fx->input_nodes_update = 0;
+  fx->multiple_driven = 0;
+  fx->traced_changed = 0;
+  fx->traced_changed_size = 0;
+  fx->wide_counts = 0;
+  fx->wide_counts_size = 0;
   return 0;
 }
 
-static struct fetx_inter_node
-fetx_get_connected_node(const struct fetx_inter_node node,
-                        const struct fetx_inter_fet fet) {
-  return *fet.connections[(node.index == fet.connections[0]->index) ? 1 : 0];
+static size_t fetx_cells_bytes(const struct fetx_cells *const cells) {
+  size_t elements = 0;
+  size_t i = 0;
+  while (i < cells->size) {
+    const struct fetx_cell *const cell = cells->cells + i;
+    elements += cell->fets_size + cell->nodes_size + cell->elements_size;
+    ++i;
+  }
+  return sizeof(*cells) + (cells->size * sizeof(*cells->cells)) +
+         (elements * sizeof(void *)) + cells->bytes;
+}
+
+/* the memory held by the runtime, not counting the paths */
+
+size_t fetx_bytes(const struct fetx *const fx) {
+  const size_t nodes_size = fx->nodes_limit - fx->nodes;
+  return (nodes_size * (sizeof(*fx->nodes) + sizeof(*fx->multiple) +
+                        sizeof(*fx->multiple_positions))) +
+         ((fx->fets_limit - fx->fets) * sizeof(*fx->fets)) +
+         (fx->levels_size * sizeof(*fx->levels)) +
+         (fx->wide_counts_size * 4 * sizeof(*fx->wide_counts)) +
+         ((fx->wheel != 0)
+              ? (sizeof(*fx->wheel) +
+                 (fx->wheel->entries_size * sizeof(*fx->wheel->entries)))
+              : 0) +
+         ((fx->cells != 0) ? fetx_cells_bytes(fx->cells) : 0);
+}
+
+/* counts a path ending at the node, moving its counts to the side table
+ * before they could overflow */
+
+static int fetx_node_add_path(struct fetx *const fx,
+                              struct fetx_node *const node) {
+  if (node->paths < UCHAR_MAX) {
+    ++node->paths;
+    if ((node->paths == UCHAR_MAX) && (node->is_wide == 0)) {
+      size_t *const wide_counts = fetx_realloc(
+          fx->wide_counts, (fx->wide_counts_size + 1) * 4,
+          sizeof(*fx->wide_counts));
+      if (wide_counts == 0) {
+        --node->paths;
+        return -1;
+      }
+      fx->wide_counts = wide_counts;
+      size_t *const counts = wide_counts + (fx->wide_counts_size * 4);
+      size_t i = 0;
+      while (i < 4) {
+        counts[i] = node->counts.narrow[i];
+        ++i;
+      }
+      node->counts.wide = fx->wide_counts_size;
+      node->is_wide = 1;
+      ++fx->wide_counts_size;
+    }
+  }
+  return 0;
 }
 
 void fetx_input_delete(struct fetx_input_node path) {
@@ -252,31 +352,48 @@ void fetx_input_delete(struct fetx_input_node path) {
   }
 }
 
+/* \on_path marks the nodes on the path when not 0, and the path counts and
+ * FET links are then left for fetx_input_link so that inputs can be built
+ * concurrently. Otherwise the node flags mark the path. */
+
 static int fetx_input_init_rec(struct fetx_input_node *const path,
                                struct fetx *const fx,
-                               const struct fetx_inter_node inter_node) {
+                               const struct fetx_graph *const graph,
+                               const size_t node_index,
+                               unsigned char *const on_path) {
 
-  struct fetx_node *const node = fx->nodes + inter_node.index;
-  node->flag = 1;
+  struct fetx_node *const node = fx->nodes + node_index;
+  if (on_path != 0) {
+    on_path[node_index] = 1;
+  } else {
+    node->flag = 1;
+  }
 
-  struct fetx_inter_fet **inter_fet_itt = inter_node.connections;
-  while (inter_fet_itt != inter_node.connections_limit) {
+  const struct fetx_graph_edge *edge = graph->edges + graph->starts[node_index];
+  const struct fetx_graph_edge *const edges_limit =
+      graph->edges + graph->starts[node_index + 1];
+  while (edge != edges_limit) {
     /* for each connection */
-    const struct fetx_inter_fet inter_fet = **inter_fet_itt;
-    const struct fetx_inter_node connected_inter_node =
-        fetx_get_connected_node(inter_node, inter_fet);
-    struct fetx_node *connected_node = fx->nodes + connected_inter_node.index;
+    struct fetx_fet *const fet = fx->fets + edge->fet;
+    struct fetx_node *connected_node = fx->nodes + edge->node;
     /* check for permanent comp pairs and FETs connected to their own gate */
     struct fetx_input_node *el = path;
+    const struct fetx_node *const control_node = fet->control;
     while ((el->link.input != 0) &&
-           ((el->link.fet->control->index != inter_fet.control->index) ||
-            (el->link.fet->type == inter_fet.type)) &&
-           (el->node->index != inter_fet.control->index)) {
+           ((el->link.fet->control != control_node) ||
+            (el->link.fet->type == fet->type)) &&
+           (el->node != control_node)) {
       el = el->link.input;
     }
+    const unsigned char is_on_path =
+        (on_path != 0) ? on_path[edge->node]
+                       : connected_node->flag;
     /* check if node is already on the path */
-    if ((el->link.input == 0) && (connected_node->flag == 0)) {
+    if ((el->link.input == 0) && (is_on_path == 0)) {
       /* add to outputs */
+      if ((on_path == 0) && (fetx_node_add_path(fx, connected_node) != 0)) {
+        return -1;
+      }
       struct fetx_input_node *const new_path = fetx_alloc(sizeof(*new_path), 1);
       if (new_path == 0) {
         return -1;
@@ -286,9 +403,10 @@ static int fetx_input_init_rec(struct fetx_input_node *const path,
       path->outputs = new_path;
 
       /* add link to FET */
-      struct fetx_fet *const fet = fx->fets + inter_fet.index;
-      new_path->link.next = fet->links;
-      fet->links = &new_path->link;
+      if (on_path == 0) {
+        new_path->link.next = fet->links;
+        fet->links = &new_path->link;
+      }
 
       /* add to path */
       new_path->node = connected_node;
@@ -300,51 +418,845 @@ static int fetx_input_init_rec(struct fetx_input_node *const path,
       new_path->is_listed = 0;
       new_path->outputs = 0;
 
-      if (fetx_input_init_rec(new_path, fx, connected_inter_node) != 0) {
+      /* a supply is held at its level, so a path reaching it can only drive
+       * it against that level and stops there */
+      if ((connected_node->is_supply == 0) &&
+          (fetx_input_init_rec(new_path, fx, graph, edge->node, on_path) !=
+           0)) {
         fetx_dealloc(new_path);
         path->outputs = 0;
         return -1;
       }
     }
-    ++inter_fet_itt;
+    ++edge;
+  }
+  if (on_path != 0) {
+    on_path[node_index] = 0;
+  } else {
+    node->flag = 0;
   }
-  node->flag = 0;
   return 0;
 }
 
-int fetx_input_init(struct fetx_input_node *const path, struct fetx *const fx,
-                    const struct fetx_inter_node inter_node) {
-  struct fetx_node *const node = fx->nodes + inter_node.index;
-  node->is_input = 1;
+static void fetx_input_root_init(struct fetx_input_node *const path,
+                                 struct fetx_node *const node) {
   path->node = node;
   path->state = FETX_UNDRIVEN;
   path->link.input = 0;
   path->outputs = 0;
   path->next_output = 0;
   path->is_listed = 0;
+}
+
+int fetx_input_init(struct fetx_input_node *const path, struct fetx *const fx,
+                    const struct fetx_graph *const graph,
+                    const size_t node_index) {
+  struct fetx_node *const node = fx->nodes + node_index;
+  node->is_input = 1;
+  fetx_input_root_init(path, node);
+
+  if (fetx_node_add_path(fx, node) != 0) {
+    return -1;
+  }
+  return fetx_input_init_rec(path, fx, graph, node_index, 0);
+}
+
+/* builds the paths of an input as fetx_input_init, leaving the runtime
+ * untouched so that several inputs can be built at once. \on_path must have
+ * a zeroed entry per node and is zeroed again on success. The paths must
+ * then be added to the runtime with fetx_input_link, in the order
+ * fetx_input_init would have built them, before the next is built. */
+
+int fetx_input_build(struct fetx_input_node *const path,
+                     const struct fetx *const fx,
+                     const struct fetx_graph *const graph,
+                     const size_t node_index, unsigned char *const on_path) {
+  fetx_input_root_init(path, fx->nodes + node_index);
+  return fetx_input_init_rec(path, (struct fetx *)fx, graph, node_index,
+                             on_path);
+}
+
+/* siblings are listed newest first, so they are linked from the back to
+ * repeat the order they were built in */
+
+static int fetx_input_link_outputs(struct fetx *const fx,
+                                   struct fetx_input_node *const output) {
+  if (output == 0) {
+    return 0;
+  }
+  if (fetx_input_link_outputs(fx, output->next_output) != 0) {
+    return -1;
+  }
+  if (fetx_node_add_path(fx, output->node) != 0) {
+    return -1;
+  }
+  struct fetx_fet *const fet = output->link.fet;
+  output->link.next = fet->links;
+  fet->links = &output->link;
+  return fetx_input_link_outputs(fx, output->outputs);
+}
+
+/* counts the paths of an input built by fetx_input_build and links them to
+ * their FETs, leaving the runtime as fetx_input_init would have */
+
+int fetx_input_link(struct fetx *const fx,
+                    struct fetx_input_node *const path) {
+  path->node->is_input = 1;
+  if (fetx_node_add_path(fx, path->node) != 0) {
+    return -1;
+  }
+  return fetx_input_link_outputs(fx, path->outputs);
+}
+
+static void fetx_input_count_rec(const struct fetx *const fx,
+                                 const struct fetx_graph *const graph,
+                                 const size_t node_index, const size_t depth,
+                                 size_t *const count, const size_t cap,
+                                 unsigned char *const on_path,
+                                 struct fetx_graph_edge *const path) {
+  on_path[node_index] = 1;
+  const struct fetx_graph_edge *edge = graph->edges + graph->starts[node_index];
+  const struct fetx_graph_edge *const edges_limit =
+      graph->edges + graph->starts[node_index + 1];
+  while ((edge != edges_limit) && (*count < cap)) {
+    /* the same checks as fetx_input_init_rec, walking \path for the links */
+    const struct fetx_fet *const fet = fx->fets + edge->fet;
+    const struct fetx_node *const control_node = fet->control;
+    size_t d = depth;
+    while ((d > 0) &&
+           ((fx->fets[path[d - 1].fet].control != control_node) ||
+            (fx->fets[path[d - 1].fet].type == fet->type)) &&
+           ((fx->nodes + path[d - 1].node) != control_node)) {
+      --d;
+    }
+    if ((d == 0) && (on_path[edge->node] == 0)) {
+      ++*count;
+      if (fx->nodes[edge->node].is_supply == 0) {
+        path[depth] = *edge;
+        fetx_input_count_rec(fx, graph, edge->node, depth + 1, count, cap,
+                             on_path, path);
+      }
+    }
+    ++edge;
+  }
+  on_path[node_index] = 0;
+}
+
+/* counts the elements fetx_input_init would build from the node, including
+ * the root, stopping at \cap so that meshes with too many paths to build
+ * can be found quickly. \on_path is as for fetx_input_build and \path
+ * holds the path walked, which needs an entry per node. */
+
+size_t fetx_input_count(const struct fetx *const fx,
+                        const struct fetx_graph *const graph,
+                        const size_t node_index, const size_t cap,
+                        unsigned char *const on_path,
+                        struct fetx_graph_edge *const path) {
+  size_t count = 1;
+  if (count < cap) {
+    fetx_input_count_rec(fx, graph, node_index, 0, &count, cap, on_path,
+                         path);
+  }
+  return count;
+}
+
+/* copies \src into \fx, which is left empty on failure. Traces aren't
+ * copied and \src must have nothing listed, every input path must then be
+ * copied with fetx_input_clone to complete the FET links. */
+
+int fetx_clone(struct fetx *const fx, const struct fetx *const src) {
+  const size_t nodes_size = src->nodes_limit - src->nodes;
+  const size_t fets_size = src->fets_limit - src->fets;
+  fx->nodes = fetx_alloc(sizeof(*fx->nodes), nodes_size);
+  fx->fets = fetx_alloc(sizeof(*fx->fets), fets_size);
+  fx->multiple = fetx_alloc(sizeof(*fx->multiple), nodes_size);
+  fx->multiple_positions =
+      fetx_alloc(sizeof(*fx->multiple_positions), nodes_size);
+  fx->wide_counts = (src->wide_counts_size != 0)
+                        ? fetx_alloc(sizeof(*fx->wide_counts),
+                                     src->wide_counts_size * 4)
+                        : 0;
+  fx->levels = (src->levels != 0)
+                   ? fetx_calloc(src->levels_size, sizeof(*fx->levels))
+                   : 0;
+  fx->wheel = (src->wheel != 0)
+                  ? fetx_wheel_new(fets_size, src->wheel->now)
+                  : 0;
+  fx->time = src->time;
+  fx->cells = 0;
+  if ((fx->nodes == 0) || (fx->fets == 0) || (fx->multiple == 0) ||
+      (fx->multiple_positions == 0) ||
+      ((fx->wide_counts == 0) && (src->wide_counts_size != 0)) ||
+      ((fx->levels == 0) && (src->levels != 0)) ||
+      ((fx->wheel == 0) && (src->wheel != 0))) {
+    fetx_dealloc_two(fx->nodes, fx->fets);
+    fetx_dealloc_two(fx->multiple, fx->multiple_positions);
+    fetx_dealloc_two(fx->wide_counts, fx->levels);
+    fetx_wheel_delete(fx->wheel);
+    return -1;
+  }
+  fx->nodes_limit = fx->nodes + nodes_size;
+  fx->fets_limit = fx->fets + fets_size;
+
+  size_t i = 0;
+  while (i < nodes_size) {
+    const struct fetx_node *const src_node = src->nodes + i;
+    struct fetx_node *const node = fx->nodes + i;
+    *node = *src_node;
+    node->control = (src_node->control != 0)
+                        ? fx->fets + (src_node->control - src->fets)
+                        : 0;
+    node->is_traced = 0;
+    node->is_trace_listed = 0;
+    fx->multiple_positions[i] = src->multiple_positions[i];
+    ++i;
+  }
+  i = 0;
+  while (i < fets_size) {
+    const struct fetx_fet *const src_fet = src->fets + i;
+    struct fetx_fet *const fet = fx->fets + i;
+    *fet = *src_fet;
+    fet->control = fx->nodes + (src_fet->control - src->nodes);
+    fet->next_control = (src_fet->next_control != 0)
+                            ? fx->fets + (src_fet->next_control - src->fets)
+                            : 0;
+    fet->next_listed = 0;
+    fet->links = 0;
+    fet->is_listed = 0;
+    fet->cell = 0;
+    ++i;
+  }
+  i = 0;
+  while (i < src->multiple_driven) {
+    fx->multiple[i] = src->multiple[i];
+    ++i;
+  }
+  i = 0;
+  while (i < (src->wide_counts_size * 4)) {
+    fx->wide_counts[i] = src->wide_counts[i];
+    ++i;
+  }
+  fx->fets_update = 0;
+  fx->input_nodes_update = 0;
+  fx->levels_size = src->levels_size;
+  fx->level = src->levels_size;
+  fx->multiple_driven = src->multiple_driven;
+  fx->traced_changed = 0;
+  fx->traced_changed_size = 0;
+  fx->wide_counts_size = src->wide_counts_size;
+  return 0;
+}
+
+static int fetx_input_clone_rec(struct fetx_input_node *const path,
+                                struct fetx *const fx,
+                                const struct fetx_input_node *const src_path,
+                                const struct fetx *const src_fx) {
+  struct fetx_input_node **tail = &path->outputs;
+  const struct fetx_input_node *src_output = src_path->outputs;
+  while (src_output != 0) {
+    struct fetx_input_node *const new_path = fetx_alloc(sizeof(*new_path), 1);
+    if (new_path == 0) {
+      return -1;
+    }
+    struct fetx_fet *const fet =
+        fx->fets + (src_output->link.fet - src_fx->fets);
+    new_path->node = fx->nodes + (src_output->node - src_fx->nodes);
+    new_path->state = src_output->state;
+    new_path->link.input = path;
+    new_path->link.output = new_path;
+    new_path->link.fet = fet;
+    new_path->link.next = fet->links;
+    fet->links = &new_path->link;
+    new_path->outputs = 0;
+    new_path->next_output = 0;
+    new_path->next_listed = 0;
+    new_path->is_listed = 0;
+    /* appended to keep the order of the outputs */
+    *tail = new_path;
+    tail = &new_path->next_output;
+
+    if (fetx_input_clone_rec(new_path, fx, src_output, src_fx) != 0) {
+      return -1;
+    }
+    src_output = src_output->next_output;
+  }
+  return 0;
+}
+
+/* copies the input path \src_path of \src_fx into \path of its copy \fx,
+ * on failure \path must still be deleted */
+
+int fetx_input_clone(struct fetx_input_node *const path, struct fetx *const fx,
+                     const struct fetx_input_node *const src_path,
+                     const struct fetx *const src_fx) {
+  path->node = fx->nodes + (src_path->node - src_fx->nodes);
+  path->state = src_path->state;
+  path->link.input = 0;
+  path->outputs = 0;
+  path->next_output = 0;
+  path->next_listed = 0;
+  path->is_listed = 0;
+  return fetx_input_clone_rec(path, fx, src_path, src_fx);
+}
+
+static void fetx_fet_add_to_list(struct fetx *const fx,
+                                 struct fetx_fet *const fet);
+
+/* N FETs only pass low states and P FETs only high ones, so a path through
+ * both types always carries FETX_UNDRIVEN unless its input is driven
+ * FETX_UNSTABLE_MULTIPLE. Only paths through a single type of FET, live paths,
+ * make a node depend on the gates along them. */
+
+struct fetx_levelise_state {
+  struct fetx *fx;
+  size_t *offsets; /* live path ends per node, nodes_size + 1 entries */
+  struct fetx_input_node **ends;
+  size_t *levels;
+  unsigned char *marks; /* 0 unvisited, 1 in progress, 2 done */
+};
+
+/* counts the live path ends at each node when \s->ends is 0, otherwise
+ * places them */
+
+static void fetx_levelise_ends(struct fetx_levelise_state *const s,
+                               struct fetx_input_node *const path) {
+  struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    if ((path->link.input == 0) ||
+        (output->link.fet->type == path->link.fet->type)) {
+      const size_t index = output->node - s->fx->nodes;
+      if (s->ends == 0) {
+        ++s->offsets[index + 1];
+      } else {
+        s->ends[s->offsets[index]] = output;
+        ++s->offsets[index];
+      }
+      fetx_levelise_ends(s, output);
+    }
+    output = output->next_output;
+  }
+}
+
+/* a node's level is one above the highest level gating any FET on a live path
+ * ending at it, returns -1 on feedback */
+
+static int fetx_levelise_node(struct fetx_levelise_state *const s,
+                              const size_t index) {
+  if (s->marks[index] == 2) {
+    return 0;
+  }
+  if (s->marks[index] == 1) {
+    return -1;
+  }
+  s->marks[index] = 1;
+  size_t level = 0;
+  size_t e = s->offsets[index];
+  while (e < s->offsets[index + 1]) {
+    const struct fetx_input_node *el = s->ends[e];
+    while (el->link.input != 0) {
+      const size_t control = el->link.fet->control - s->fx->nodes;
+      if (fetx_levelise_node(s, control) != 0) {
+        return -1;
+      }
+      if (s->levels[control] >= level) {
+        level = s->levels[control] + 1;
+      }
+      el = el->link.input;
+    }
+    ++e;
+  }
+  s->levels[index] = level;
+  s->marks[index] = 2;
+  return 0;
+}
+
+static void fetx_levelise_state_delete(struct fetx_levelise_state s) {
+  fetx_dealloc(s.offsets);
+  fetx_dealloc(s.ends);
+  fetx_dealloc(s.levels);
+  fetx_dealloc(s.marks);
+}
+
+/* finds the level of every node into \s, which must be deleted after.
+ * Returns -1 on an allocation error, 1 if the circuit has feedback. */
+
+static int fetx_levelise_analyse(struct fetx_levelise_state *const s,
+                                 size_t *const levels_size,
+                                 struct fetx *const fx,
+                                 struct fetx_input_node *const inputs,
+                                 const size_t inputs_size) {
+  const size_t nodes_size = fx->nodes_limit - fx->nodes;
+  s->fx = fx;
+  s->ends = 0;
+  s->offsets = fetx_calloc(nodes_size + 1, sizeof(*s->offsets));
+  s->levels = fetx_alloc(sizeof(*s->levels), nodes_size);
+  s->marks = fetx_calloc(nodes_size, sizeof(*s->marks));
+  if ((s->offsets == 0) || (s->levels == 0) || (s->marks == 0)) {
+    return -1;
+  }
+
+  size_t i = 0;
+  while (i < inputs_size) {
+    fetx_levelise_ends(s, inputs + i);
+    ++i;
+  }
+  i = 0;
+  while (i < nodes_size) {
+    s->offsets[i + 1] += s->offsets[i];
+    ++i;
+  }
+  s->ends = fetx_alloc(sizeof(*s->ends), s->offsets[nodes_size]);
+  if (s->ends == 0) {
+    return -1;
+  }
+  /* fill using the row starts as cursors then shift them back */
+  i = 0;
+  while (i < inputs_size) {
+    fetx_levelise_ends(s, inputs + i);
+    ++i;
+  }
+  i = nodes_size;
+  while (i > 0) {
+    s->offsets[i] = s->offsets[i - 1];
+    --i;
+  }
+  s->offsets[0] = 0;
+
+  *levels_size = 1;
+  i = 0;
+  while (i < nodes_size) {
+    if (fetx_levelise_node(s, i) != 0) {
+      return 1;
+    }
+    if (s->levels[i] >= *levels_size) {
+      *levels_size = s->levels[i] + 1;
+    }
+    ++i;
+  }
+  return 0;
+}
+
+/* returns 1 if the circuit has feedback, in which case its settled state can
+ * depend on earlier inputs, 0 if not and -1 on an allocation error */
+
+int fetx_feedback_test(struct fetx *const fx,
+                       struct fetx_input_node *const inputs,
+                       const size_t inputs_size) {
+  struct fetx_levelise_state s;
+  size_t levels_size;
+  const int ret = fetx_levelise_analyse(&s, &levels_size, fx, inputs,
+                                        inputs_size);
+  fetx_levelise_state_delete(s);
+  return ret;
+}
+
+/* orders FET updates by the longest chain of gates ahead of them, so that
+ * each FET in a circuit without feedback is updated at most once per change
+ * of the inputs. Needs every input path to have been initialised. */
+
+int fetx_levelise(struct fetx *const fx, struct fetx_input_node *const inputs,
+                  const size_t inputs_size) {
+  struct fetx_levelise_state s;
+  size_t levels_size;
+  const int ret = fetx_levelise_analyse(&s, &levels_size, fx, inputs,
+                                        inputs_size);
+  if (ret != 0) {
+    fetx_levelise_state_delete(s);
+    return ret;
+  }
+
+  fx->levels = fetx_calloc(levels_size, sizeof(*fx->levels));
+  if (fx->levels == 0) {
+    fetx_levelise_state_delete(s);
+    return -1;
+  }
+  fx->levels_size = levels_size;
+  fx->level = levels_size;
+
+  /* move anything already listed into its level */
+  struct fetx_fet *fet = fx->fets;
+  while (fet < fx->fets_limit) {
+    fet->level = s.levels[fet->control - fx->nodes];
+    ++fet;
+  }
+  fet = fx->fets_update;
+  fx->fets_update = 0;
+  while (fet != 0) {
+    struct fetx_fet *const next = fet->next_listed;
+    fet->is_listed = 0;
+    fetx_fet_add_to_list(fx, fet);
+    fet = next;
+  }
+  fetx_levelise_state_delete(s);
+  return 0;
+}
+
+/* cells are bounded by FETs of this many and key on 2 bits per FET, with a
+ * bounded number of combinations kept for each */
+
+#define FETX_CELL_FETS 16
+#define FETX_CELL_ENTRIES 1024
+#define FETX_CELL_NONE ((size_t)-1)
+
+void fetx_cells_delete(struct fetx_cells *const cells) {
+  if (cells == 0) {
+    return;
+  }
+  size_t i = 0;
+  while (i < cells->size) {
+    fetx_dealloc_two(cells->cells[i].keys, cells->cells[i].values);
+    ++i;
+  }
+  fetx_dealloc_two(cells->cells, cells->fets);
+  fetx_dealloc_two(cells->nodes, cells->elements);
+  fetx_dealloc(cells);
+}
+
+static size_t fetx_cells_find(size_t *const parents, size_t node) {
+  while (parents[node] != node) {
+    parents[node] = parents[parents[node]];
+    node = parents[node];
+  }
+  return node;
+}
+
+/* the node whose cell a path element is in, the one it comes from if it ends
+ * at a supply, FETX_CELL_NONE between two supplies */
+
+static size_t fetx_cells_node(const struct fetx *const fx,
+                              const struct fetx_input_node *const element) {
+  if (element->node->is_supply == 0) {
+    return element->node - fx->nodes;
+  }
+  const struct fetx_node *const from = element->link.input->node;
+  return (from->is_supply == 0) ? (size_t)(from - fx->nodes) : FETX_CELL_NONE;
+}
+
+/* joins the nodes either side of each FET on the paths, except supplies */
+
+static void fetx_cells_join(const struct fetx *const fx, size_t *const parents,
+                            const struct fetx_input_node *const path) {
+  const struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    if ((path->node->is_supply == 0) && (output->node->is_supply == 0)) {
+      const size_t a = fetx_cells_find(parents, path->node - fx->nodes);
+      const size_t b = fetx_cells_find(parents, output->node - fx->nodes);
+      parents[a] = b;
+    }
+    fetx_cells_join(fx, parents, output);
+    output = output->next_output;
+  }
+}
+
+struct fetx_cells_set {
+  size_t elements;
+  size_t leaves;
+  size_t fets;
+  size_t nodes;
+  size_t cell; /* index of its cell, FETX_CELL_NONE if not memoised */
+  unsigned int is_invalid : 1;
+};
+
+static void fetx_cells_count(const struct fetx *const fx,
+                             size_t *const parents,
+                             struct fetx_cells_set *const sets,
+                             const struct fetx_input_node *const path) {
+  const struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    const size_t node = fetx_cells_node(fx, output);
+    if (node != FETX_CELL_NONE) {
+      struct fetx_cells_set *const set = sets + fetx_cells_find(parents, node);
+      ++set->elements;
+      if (output->node->is_supply != 0) {
+        ++set->leaves;
+      } else if (output->node->flag == 0) {
+        output->node->flag = 1;
+        ++set->nodes;
+      }
+    }
+    fetx_cells_count(fx, parents, sets, output);
+    output = output->next_output;
+  }
+}
+
+/* \ends holds where the next element and leaf of each cell goes */
+
+static void fetx_cells_fill(struct fetx *const fx, size_t *const parents,
+                            const struct fetx_cells_set *const sets,
+                            size_t *const ends,
+                            const struct fetx_input_node *const path) {
+  struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    const size_t node = fetx_cells_node(fx, output);
+    if (node != FETX_CELL_NONE) {
+      const size_t index = sets[fetx_cells_find(parents, node)].cell;
+      if (index != FETX_CELL_NONE) {
+        struct fetx_cell *const cell = fx->cells->cells + index;
+        if (output->node->is_supply != 0) {
+          cell->elements[ends[(index * 2) + 1]] = output;
+          ++ends[(index * 2) + 1];
+        } else {
+          cell->elements[ends[index * 2]] = output;
+          ++ends[index * 2];
+          if (output->node->flag == 0) {
+            output->node->flag = 1;
+            cell->nodes[cell->nodes_size] = output->node;
+            ++cell->nodes_size;
+          }
+        }
+      }
+    }
+    fetx_cells_fill(fx, parents, sets, ends, output);
+    output = output->next_output;
+  }
+}
+
+static void fetx_cells_unflag(struct fetx *const fx) {
+  struct fetx_node *node = fx->nodes;
+  while (node < fx->nodes_limit) {
+    node->flag = 0;
+    ++node;
+  }
+}
+
+/* splits the paths of the \roots_size roots in \roots into the cells between
+ * the supplies. Cells holding an input, a node with too many paths for 8 bit
+ * counts or too many FETs aren't memoised. */
+
+int fetx_cells_init(struct fetx *const fx,
+                    struct fetx_input_node *const roots,
+                    const size_t roots_size) {
+  if (fx->wheel != 0) {
+    return 0;
+  }
+  const size_t nodes_size = fx->nodes_limit - fx->nodes;
+  size_t *const parents = fetx_alloc(sizeof(*parents), nodes_size);
+  struct fetx_cells_set *const sets = fetx_calloc(nodes_size, sizeof(*sets));
+  fx->cells = fetx_calloc(1, sizeof(*fx->cells));
+  if ((parents == 0) || (sets == 0) || (fx->cells == 0)) {
+    fetx_dealloc_two(parents, sets);
+    fetx_dealloc(fx->cells);
+    fx->cells = 0;
+    return -1;
+  }
+  size_t i = 0;
+  while (i < nodes_size) {
+    parents[i] = i;
+    ++i;
+  }
+  i = 0;
+  while (i < roots_size) {
+    fetx_cells_join(fx, parents, roots + i);
+    ++i;
+  }
+  i = 0;
+  while (i < roots_size) {
+    fetx_cells_count(fx, parents, sets, roots + i);
+    ++i;
+  }
+  fetx_cells_unflag(fx);
+
+  struct fetx_fet *fet = fx->fets;
+  while (fet < fx->fets_limit) {
+    if (fet->links != 0) {
+      const size_t node = fetx_cells_node(fx, fet->links->output);
+      if (node != FETX_CELL_NONE) {
+        ++sets[fetx_cells_find(parents, node)].fets;
+      }
+    }
+    ++fet;
+  }
+  i = 0;
+  while (i < nodes_size) {
+    const struct fetx_node *const node = fx->nodes + i;
+    if ((node->is_supply == 0) &&
+        ((node->is_input != 0) || (node->is_wide != 0))) {
+      sets[fetx_cells_find(parents, i)].is_invalid = 1;
+    }
+    ++i;
+  }
+
+  /* number the cells and size their arrays */
+  struct fetx_cells *const cells = fx->cells;
+  size_t fets_size = 0;
+  size_t cells_nodes_size = 0;
+  size_t elements_size = 0;
+  i = 0;
+  while (i < nodes_size) {
+    struct fetx_cells_set *const set = sets + i;
+    if ((set->elements != 0) && (set->fets != 0) &&
+        (set->fets <= FETX_CELL_FETS) && (set->is_invalid == 0)) {
+      set->cell = cells->size;
+      ++cells->size;
+      fets_size += set->fets;
+      cells_nodes_size += set->nodes;
+      elements_size += set->elements;
+    } else {
+      set->cell = FETX_CELL_NONE;
+    }
+    ++i;
+  }
+  size_t *const ends = fetx_alloc(sizeof(*ends), cells->size * 2);
+  cells->cells = fetx_calloc(cells->size, sizeof(*cells->cells));
+  cells->fets = fetx_alloc(sizeof(*cells->fets), fets_size);
+  cells->nodes = fetx_alloc(sizeof(*cells->nodes), cells_nodes_size);
+  cells->elements = fetx_alloc(sizeof(*cells->elements), elements_size);
+  if ((cells->size != 0) &&
+      ((ends == 0) || (cells->cells == 0) || (cells->fets == 0) ||
+       (cells->nodes == 0) || (cells->elements == 0))) {
+    fetx_dealloc_two(parents, sets);
+    fetx_dealloc(ends);
+    cells->size = 0;
+    fetx_cells_delete(cells);
+    fx->cells = 0;
+    return -1;
+  }
+  fets_size = 0;
+  cells_nodes_size = 0;
+  elements_size = 0;
+  i = 0;
+  while (i < nodes_size) {
+    const struct fetx_cells_set *const set = sets + i;
+    if (set->cell != FETX_CELL_NONE) {
+      struct fetx_cell *const cell = cells->cells + set->cell;
+      cell->fets = cells->fets + fets_size;
+      cell->nodes = cells->nodes + cells_nodes_size;
+      cell->elements = cells->elements + elements_size;
+      cell->elements_size = set->elements;
+      cell->leaves_size = set->leaves;
+      ends[set->cell * 2] = 0;
+      ends[(set->cell * 2) + 1] = set->elements - set->leaves;
+      fets_size += set->fets;
+      cells_nodes_size += set->nodes;
+      elements_size += set->elements;
+    }
+    ++i;
+  }
+
+  fet = fx->fets;
+  while (fet < fx->fets_limit) {
+    if (fet->links != 0) {
+      const size_t node = fetx_cells_node(fx, fet->links->output);
+      if (node != FETX_CELL_NONE) {
+        const size_t index = sets[fetx_cells_find(parents, node)].cell;
+        if (index != FETX_CELL_NONE) {
+          struct fetx_cell *const cell = cells->cells + index;
+          cell->fets[cell->fets_size] = fet;
+          ++cell->fets_size;
+          fet->cell = cell;
+        }
+      }
+    }
+    ++fet;
+  }
+  /* inputs are in cells that aren't memoised, so only the supplies are
+   * walked */
+  i = 0;
+  while (i < roots_size) {
+    if (roots[i].node->is_supply != 0) {
+      fetx_cells_fill(fx, parents, sets, ends, roots + i);
+    }
+    ++i;
+  }
+  fetx_cells_unflag(fx);
+  fetx_dealloc_two(parents, sets);
+  fetx_dealloc(ends);
+  return 0;
+}
+
+/* the node, FET and link state functions are table lookups unless
+ * FETX_NO_TABLES is defined, then they branch on their arguments */
+
+#ifndef FETX_NO_TABLES
+
+/* node state for each state_mask, a low or high beats an unstable state of
+ * the same level, any low with any high is FETX_UNSTABLE_MULTIPLE */
+
+static const enum fetx_node_states fetx_node_states_by_mask[16] = {
+    FETX_UNDRIVEN,          FETX_LOW,
+    FETX_HIGH,              FETX_UNSTABLE_MULTIPLE,
+    FETX_UNSTABLE_LOW,      FETX_LOW,
+    FETX_UNSTABLE_MULTIPLE, FETX_UNSTABLE_MULTIPLE,
+    FETX_UNSTABLE_HIGH,     FETX_UNSTABLE_MULTIPLE,
+    FETX_HIGH,              FETX_UNSTABLE_MULTIPLE,
+    FETX_UNSTABLE_MULTIPLE, FETX_UNSTABLE_MULTIPLE,
+    FETX_UNSTABLE_MULTIPLE, FETX_UNSTABLE_MULTIPLE};
+
+/* indexed with FET type, FET state then link input state. N FETs pass low
+ * states and P FETs high ones, an unstable FET makes a stable state
+ * unstable */
 
-  return fetx_input_init_rec(path, fx, inter_node);
+static const enum fetx_node_states fetx_link_outputs[2][3][6] = {
+    [FETX_FET_N] =
+        {[FETX_OPEN] = {FETX_UNDRIVEN, FETX_UNDRIVEN, FETX_UNDRIVEN,
+                        FETX_UNDRIVEN, FETX_UNDRIVEN, FETX_UNDRIVEN},
+         [FETX_CLOSED] = {FETX_LOW, FETX_UNDRIVEN, FETX_UNSTABLE_LOW,
+                          FETX_UNDRIVEN, FETX_UNSTABLE_MULTIPLE,
+                          FETX_UNDRIVEN},
+         [FETX_UNSTABLE] = {FETX_UNSTABLE_LOW, FETX_UNDRIVEN,
+                            FETX_UNSTABLE_LOW, FETX_UNDRIVEN,
+                            FETX_UNSTABLE_MULTIPLE, FETX_UNDRIVEN}},
+    [FETX_FET_P] =
+        {[FETX_OPEN] = {FETX_UNDRIVEN, FETX_UNDRIVEN, FETX_UNDRIVEN,
+                        FETX_UNDRIVEN, FETX_UNDRIVEN, FETX_UNDRIVEN},
+         [FETX_CLOSED] = {FETX_UNDRIVEN, FETX_HIGH, FETX_UNDRIVEN,
+                          FETX_UNSTABLE_HIGH, FETX_UNSTABLE_MULTIPLE,
+                          FETX_UNDRIVEN},
+         [FETX_UNSTABLE] = {FETX_UNDRIVEN, FETX_UNSTABLE_HIGH, FETX_UNDRIVEN,
+                            FETX_UNSTABLE_HIGH, FETX_UNSTABLE_MULTIPLE,
+                            FETX_UNDRIVEN}}};
+
+enum fetx_node_states fetx_node_state_get(const struct fetx_node node) {
+  return fetx_node_states_by_mask[node.state_mask];
 }
 
-static int fetx_node_state_test(const size_t *const state_counts) {
-  return ((state_counts[0] != 0) || (state_counts[2] != 0)) ? -1 : 0;
+static enum fetx_node_states fetx_link_get_output(const struct fetx_link link) {
+  return fetx_link_outputs[link.fet->type][link.fet->state][link.input->state];
+}
+
+/* FET state for each (type << 4) | control state_mask. An N FET is open on
+ * a low gate and a P FET on a high one, they close on the other stable state
+ * and are unstable otherwise */
+
+static const unsigned char fetx_fet_states_by_key[32] = {
+    /* N */
+    FETX_UNSTABLE, FETX_OPEN, FETX_CLOSED, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_OPEN, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_CLOSED, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_UNSTABLE,
+    /* P */
+    FETX_UNSTABLE, FETX_CLOSED, FETX_OPEN, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_CLOSED, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_OPEN, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE, FETX_UNSTABLE,
+    FETX_UNSTABLE};
+
+#ifndef FETX_SIMD
+
+static enum fetx_fet_states fetx_fet_state_get(const struct fetx_fet fet) {
+  return (enum fetx_fet_states)
+      fetx_fet_states_by_key[(fet.type << 4) | fet.control->state_mask];
 }
 
+#endif
+
+#else
+
 enum fetx_node_states fetx_node_state_get(const struct fetx_node node) {
-  if (node.state_counts[FETX_LOW] != 0) {
-    return (fetx_node_state_test(node.state_counts + FETX_HIGH) != 0)
-               ? FETX_UNSTABLE_MULTIPLE
-               : FETX_LOW;
-  } else if (node.state_counts[FETX_HIGH] != 0) {
-    return (fetx_node_state_test(node.state_counts + FETX_LOW) != 0)
-               ? FETX_UNSTABLE_MULTIPLE
-               : FETX_HIGH;
-  } else if (node.state_counts[FETX_UNSTABLE_LOW] != 0) {
-    return (node.state_counts[FETX_UNSTABLE_HIGH] != 0) ? FETX_UNSTABLE_MULTIPLE
-                                                        : FETX_UNSTABLE_LOW;
-  }
-  return (node.state_counts[FETX_UNSTABLE_HIGH] != 0) ? FETX_UNSTABLE_HIGH
-                                                      : FETX_UNDRIVEN;
+  const unsigned int mask = node.state_mask;
+  const unsigned int low =
+      mask & ((1u << FETX_LOW) | (1u << FETX_UNSTABLE_LOW));
+  const unsigned int high =
+      mask & ((1u << FETX_HIGH) | (1u << FETX_UNSTABLE_HIGH));
+  if ((low != 0) && (high != 0)) {
+    return FETX_UNSTABLE_MULTIPLE;
+  } else if ((mask & (1u << FETX_LOW)) != 0) {
+    return FETX_LOW;
+  } else if ((mask & (1u << FETX_HIGH)) != 0) {
+    return FETX_HIGH;
+  } else if (low != 0) {
+    return FETX_UNSTABLE_LOW;
+  }
+  return (high != 0) ? FETX_UNSTABLE_HIGH : FETX_UNDRIVEN;
 }
 
 static enum fetx_fet_states fetx_fet_state_get(const struct fetx_fet fet) {
@@ -366,25 +1278,6 @@ static enum fetx_fet_states fetx_fet_state_get(const struct fetx_fet fet) {
   return state;
 }
 
-static void
-fetx_input_node_add_to_list(struct fetx *const fx,
-                            struct fetx_input_node *const input_node) {
-  if (input_node->is_listed == 0) {
-    input_node->next_listed = fx->input_nodes_update;
-    fx->input_nodes_update = input_node;
-    input_node->is_listed = 1;
-  }
-}
-
-static void fetx_fet_add_to_list(struct fetx *const fx,
-                                 struct fetx_fet *const fet) {
-  if (fet->is_listed == 0) {
-    fet->next_listed = fx->fets_update;
-    fx->fets_update = fet;
-    fet->is_listed = 1;
-  }
-}
-
 static enum fetx_node_states fetx_link_get_output(const struct fetx_link link) {
   enum fetx_node_states input_state = link.input->state;
   const struct fetx_fet fet = *link.fet;
@@ -406,6 +1299,60 @@ static enum fetx_node_states fetx_link_get_output(const struct fetx_link link) {
   return input_state;
 }
 
+#endif
+
+static void
+fetx_input_node_add_to_list(struct fetx *const fx,
+                            struct fetx_input_node *const input_node) {
+  if (input_node->is_listed == 0) {
+    input_node->next_listed = fx->input_nodes_update;
+    fx->input_nodes_update = input_node;
+    input_node->is_listed = 1;
+  }
+}
+
+static void fetx_fet_add_to_list(struct fetx *const fx,
+                                 struct fetx_fet *const fet) {
+  if (fx->wheel != 0) {
+    /* a FET switches its delay after the last change of its gate, so pulses
+     * shorter than that are swallowed */
+    const unsigned long long int time = fx->time + fet->delay;
+    if ((fet->is_listed == 0) ||
+        (fx->wheel->entries[fet->index].time != time)) {
+      fetx_wheel_insert(fx->wheel, fet->index, time);
+      fet->is_listed = 1;
+    }
+    return;
+  }
+  if (fet->is_listed == 0) {
+    if (fx->levels != 0) {
+      fet->next_listed = fx->levels[fet->level];
+      fx->levels[fet->level] = fet;
+      if (fet->level < fx->level) {
+        fx->level = fet->level;
+      }
+    } else {
+      fet->next_listed = fx->fets_update;
+      fx->fets_update = fet;
+    }
+    fet->is_listed = 1;
+  }
+}
+
+/* lists a cell to be looked up at the end of the step, \flush when the
+ * supply above it changed */
+
+static void fetx_cell_add_to_list(struct fetx *const fx,
+                                  struct fetx_cell *const cell,
+                                  const unsigned char flush) {
+  cell->flush |= flush;
+  if (cell->is_listed == 0) {
+    cell->next_listed = fx->cells->update;
+    fx->cells->update = cell;
+    cell->is_listed = 1;
+  }
+}
+
 static void fetx_input_node_update(struct fetx *const fx,
                                    struct fetx_input_node *const node);
 
@@ -417,6 +1364,10 @@ static void fetx_fet_change_state(struct fetx *const fx,
   if (state != fet->state) {
     /* update state */
     fet->state = state;
+    if (fet->cell != 0) {
+      fetx_cell_add_to_list(fx, fet->cell, 0);
+      return;
+    }
     /* update output nodes */
     struct fetx_link *link = fet->links;
     while (link != 0) {
@@ -426,31 +1377,92 @@ static void fetx_fet_change_state(struct fetx *const fx,
   }
 }
 
-/* updates a FET and removes the listed flag */
+/* a node is multiply driven while it has both a low and a high state */
 
-static void fetx_fet_update(struct fetx *const fx, struct fetx_fet *const fet) {
-  enum fetx_fet_states new_state = fetx_fet_state_get(*fet);
-  fetx_fet_change_state(fx, fet, new_state);
-  fet->is_listed = 0;
+static int fetx_node_multiple_test(const struct fetx_node *const node) {
+  return (fetx_node_state_get(*node) == FETX_UNSTABLE_MULTIPLE) ? -1 : 0;
+}
+
+/* keeps the multiply driven and traced nodes as the state mask changes */
+
+static void fetx_node_mask_set(struct fetx *const fx,
+                               struct fetx_node *const node,
+                               const unsigned int mask) {
+  const int was_multiple = fetx_node_multiple_test(node);
+  node->state_mask = mask;
+  const int is_multiple = fetx_node_multiple_test(node);
+  if (is_multiple != was_multiple) {
+    const size_t index = node - fx->nodes;
+    if (is_multiple != 0) {
+      fx->multiple[fx->multiple_driven] = index;
+      fx->multiple_positions[index] = fx->multiple_driven;
+      ++fx->multiple_driven;
+    } else {
+      /* swap the last entry into the gap */
+      --fx->multiple_driven;
+      const size_t last = fx->multiple[fx->multiple_driven];
+      const size_t position = fx->multiple_positions[index];
+      fx->multiple[position] = last;
+      fx->multiple_positions[last] = position;
+    }
+  }
+  if ((node->is_traced != 0) && (node->is_trace_listed == 0)) {
+    fx->traced_changed[fx->traced_changed_size] = node - fx->nodes;
+    ++fx->traced_changed_size;
+    node->is_trace_listed = 1;
+  }
 }
 
-static void fetx_node_update_input(struct fetx_node *const node,
+static void fetx_node_update_input(struct fetx *const fx,
+                                   struct fetx_node *const node,
                                    enum fetx_node_states old_state,
                                    enum fetx_node_states new_state) {
-  if (old_state < (sizeof(node->state_counts) / sizeof(*node->state_counts))) {
-    --node->state_counts[old_state];
+  unsigned int mask = node->state_mask;
+  if (node->is_wide != 0) {
+    size_t *const counts = fx->wide_counts + (node->counts.wide * 4);
+    if ((old_state < 4) && (--counts[old_state] == 0)) {
+      mask &= ~(1u << old_state);
+    }
+    if ((new_state < 4) && (counts[new_state]++ == 0)) {
+      mask |= 1u << new_state;
+    }
+  } else {
+    unsigned char *const counts = node->counts.narrow;
+    if ((old_state < 4) && (--counts[old_state] == 0)) {
+      mask &= ~(1u << old_state);
+    }
+    if ((new_state < 4) && (counts[new_state]++ == 0)) {
+      mask |= 1u << new_state;
+    }
   }
-  if (new_state < (sizeof(node->state_counts) / sizeof(*node->state_counts))) {
-    ++node->state_counts[new_state];
+  fetx_node_mask_set(fx, node, mask);
+}
+
+static void fetx_node_control_list(struct fetx *const fx,
+                                   const struct fetx_node *const node) {
+  struct fetx_fet *control = node->control;
+  while (control != 0) {
+    fetx_fet_add_to_list(fx, control);
+    control = control->next_control;
   }
 }
 
+/* updates the node counts and lists the FETs the node controls */
+
+static void fetx_input_state_change(struct fetx *const fx,
+                                    struct fetx_input_node *const input_node,
+                                    const enum fetx_node_states new_state) {
+  fetx_node_update_input(fx, input_node->node, input_node->state,
+                         new_state);
+  input_node->state = new_state;
+  fetx_node_control_list(fx, input_node->node);
+}
+
 void fetx_input_state_set(struct fetx *const fx,
                           struct fetx_input_node *const input_node,
                           const enum fetx_node_states new_state) {
   if (new_state != input_node->state) {
-    fetx_node_update_input(input_node->node, input_node->state, new_state);
-    input_node->state = new_state;
+    fetx_input_state_change(fx, input_node, new_state);
 
     /* update nodes */
     struct fetx_input_node *output = input_node->outputs;
@@ -458,20 +1470,80 @@ void fetx_input_state_set(struct fetx *const fx,
       fetx_input_node_update(fx, output->link.output);
       output = output->next_output;
     }
-    /* update FETs */
-    struct fetx_fet *control = input_node->node->control;
-    while (control != 0) {
-      fetx_fet_add_to_list(fx, control);
-      control = control->next_control;
+  }
+}
+
+/* lists the output nodes instead of updating them */
+
+void fetx_input_state_list(struct fetx *const fx,
+                           struct fetx_input_node *const input_node,
+                           const enum fetx_node_states new_state) {
+  if (new_state != input_node->state) {
+    fetx_input_state_change(fx, input_node, new_state);
+
+    struct fetx_input_node *output = input_node->outputs;
+    while (output != 0) {
+      fetx_input_node_add_to_list(fx, output);
+      output = output->next_output;
     }
   }
 }
 
 static void fetx_input_node_update(struct fetx *const fx,
                                    struct fetx_input_node *const node) {
+  if (node->link.fet->cell != 0) {
+    /* only the supply above a memoised cell can change into it */
+    fetx_cell_add_to_list(fx, node->link.fet->cell, 1);
+    return;
+  }
   fetx_input_state_set(fx, node, fetx_link_get_output(node->link));
 }
 
+#if defined(FETX_SIMD) && !defined(FETX_NO_TABLES)
+
+/* control node states can't change while the listed FETs are updated, so
+ * their new states are looked up a block at a time and only the FETs that
+ * changed are visited again, in list order */
+
+static void fetx_fets_update(struct fetx *const fx) {
+  struct fetx_fet *block[FETX_SIMD_BLOCK];
+  unsigned char keys[FETX_SIMD_BLOCK] = {0};
+  unsigned char states[FETX_SIMD_BLOCK] = {0};
+  struct fetx_fet *fet = fx->fets_update;
+  while (fet != 0) {
+    size_t size = 0;
+    while ((fet != 0) && (size < FETX_SIMD_BLOCK)) {
+      block[size] = fet;
+      keys[size] = (unsigned char)((fet->type << 4) | fet->control->state_mask);
+      states[size] = (unsigned char)fet->state;
+      fet->is_listed = 0;
+      fet = fet->next_listed;
+      ++size;
+    }
+    unsigned long int changed =
+        fetx_fet_states_block(states, keys, size, fetx_fet_states_by_key);
+    size_t i = 0;
+    while (changed != 0) {
+      if ((changed & 1) != 0) {
+        fetx_fet_change_state(fx, block[i], states[i]);
+      }
+      changed >>= 1;
+      ++i;
+    }
+  }
+  fx->fets_update = 0;
+}
+
+#else
+
+/* updates a FET and removes the listed flag */
+
+static void fetx_fet_update(struct fetx *const fx, struct fetx_fet *const fet) {
+  enum fetx_fet_states new_state = fetx_fet_state_get(*fet);
+  fetx_fet_change_state(fx, fet, new_state);
+  fet->is_listed = 0;
+}
+
 static void fetx_fets_update(struct fetx *const fx) {
   struct fetx_fet *fet = fx->fets_update;
   while (fet != 0) {
@@ -482,7 +1554,206 @@ static void fetx_fets_update(struct fetx *const fx) {
   fx->fets_update = 0;
 }
 
-static void fetx_input_nodes_update(struct fetx *const fx) {
+#endif
+
+/* the FET states of a cell packed 2 bits each, + 1 so that 0 is free to mark
+ * empty slots */
+
+static unsigned long long int
+fetx_cell_key(const struct fetx_cell *const cell) {
+  unsigned long long int key = 0;
+  size_t i = 0;
+  while (i < cell->fets_size) {
+    key = (key << 2) | (unsigned long long int)cell->fets[i]->state;
+    ++i;
+  }
+  return key + 1;
+}
+
+/* the slot holding \key, or the empty one it would go in */
+
+static size_t fetx_cell_slot(const unsigned long long int *const keys,
+                             const size_t table_size,
+                             const unsigned long long int key) {
+  const size_t mask = table_size - 1;
+  size_t slot = (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+  while ((keys[slot] != 0) && (keys[slot] != key)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+static void fetx_cell_apply(struct fetx *const fx,
+                            const struct fetx_cell *const cell,
+                            const unsigned char *const values) {
+  size_t i = 0;
+  while (i < cell->nodes_size) {
+    struct fetx_node *const node = cell->nodes[i];
+    if (node->state_mask != values[i]) {
+      fetx_node_mask_set(fx, node, values[i]);
+      fetx_node_control_list(fx, node);
+    }
+    ++i;
+  }
+  struct fetx_input_node **leaf =
+      cell->elements + (cell->elements_size - cell->leaves_size);
+  const unsigned char *state = values + cell->nodes_size;
+  while (leaf != cell->elements + cell->elements_size) {
+    if ((*leaf)->state != *state) {
+      fetx_input_state_change(fx, *leaf, (enum fetx_node_states)*state);
+    }
+    ++leaf;
+    ++state;
+  }
+}
+
+/* updates every path of the cell from the supplies down and counts them
+ * again, as lookups leave them stale */
+
+static void fetx_cell_walk(struct fetx *const fx,
+                           const struct fetx_cell *const cell) {
+  size_t i = 0;
+  while (i < cell->nodes_size) {
+    unsigned char *const counts = cell->nodes[i]->counts.narrow;
+    counts[FETX_LOW] = 0;
+    counts[FETX_HIGH] = 0;
+    counts[FETX_UNSTABLE_LOW] = 0;
+    counts[FETX_UNSTABLE_HIGH] = 0;
+    ++i;
+  }
+  const size_t leaves = cell->elements_size - cell->leaves_size;
+  i = 0;
+  while (i < leaves) {
+    struct fetx_input_node *const element = cell->elements[i];
+    const enum fetx_node_states state = fetx_link_get_output(element->link);
+    element->state = state;
+    if (state < 4) {
+      ++element->node->counts.narrow[state];
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < cell->nodes_size) {
+    struct fetx_node *const node = cell->nodes[i];
+    const unsigned char *const counts = node->counts.narrow;
+    const unsigned int mask =
+        ((counts[FETX_LOW] != 0) ? (1u << FETX_LOW) : 0) |
+        ((counts[FETX_HIGH] != 0) ? (1u << FETX_HIGH) : 0) |
+        ((counts[FETX_UNSTABLE_LOW] != 0) ? (1u << FETX_UNSTABLE_LOW) : 0) |
+        ((counts[FETX_UNSTABLE_HIGH] != 0) ? (1u << FETX_UNSTABLE_HIGH) : 0);
+    if (node->state_mask != mask) {
+      fetx_node_mask_set(fx, node, mask);
+      fetx_node_control_list(fx, node);
+    }
+    ++i;
+  }
+  i = leaves;
+  while (i < cell->elements_size) {
+    struct fetx_input_node *const leaf = cell->elements[i];
+    const enum fetx_node_states state = fetx_link_get_output(leaf->link);
+    if (leaf->state != state) {
+      fetx_input_state_change(fx, leaf, state);
+    }
+    ++i;
+  }
+}
+
+/* keeps the states the cell settled in for \key. The table doubles when half
+ * full, failing to grow it only loses the entry. */
+
+static void fetx_cell_store(struct fetx_cells *const cells,
+                            struct fetx_cell *const cell,
+                            const unsigned long long int key) {
+  const size_t stride = cell->nodes_size + cell->leaves_size;
+  if (cell->entries_size == FETX_CELL_ENTRIES) {
+    return;
+  }
+  if (((cell->entries_size + 1) * 2) > cell->table_size) {
+    const size_t table_size =
+        (cell->table_size != 0) ? (cell->table_size * 2) : 8;
+    unsigned long long int *const keys =
+        fetx_calloc(table_size, sizeof(*keys));
+    unsigned char *const values =
+        fetx_alloc(sizeof(*values), table_size * stride);
+    if ((keys == 0) || ((values == 0) && (stride != 0))) {
+      fetx_dealloc_two(keys, values);
+      return;
+    }
+    size_t i = 0;
+    while (i < cell->table_size) {
+      if (cell->keys[i] != 0) {
+        const size_t slot = fetx_cell_slot(keys, table_size, cell->keys[i]);
+        keys[slot] = cell->keys[i];
+        size_t j = 0;
+        while (j < stride) {
+          values[(slot * stride) + j] = cell->values[(i * stride) + j];
+          ++j;
+        }
+      }
+      ++i;
+    }
+    fetx_dealloc_two(cell->keys, cell->values);
+    cells->bytes += (table_size - cell->table_size) *
+                    (sizeof(*keys) + (stride * sizeof(*values)));
+    cell->keys = keys;
+    cell->values = values;
+    cell->table_size = table_size;
+  }
+  const size_t slot = fetx_cell_slot(cell->keys, cell->table_size, key);
+  cell->keys[slot] = key;
+  unsigned char *const value = cell->values + (slot * stride);
+  size_t i = 0;
+  while (i < cell->nodes_size) {
+    value[i] = (unsigned char)cell->nodes[i]->state_mask;
+    ++i;
+  }
+  const size_t leaves = cell->elements_size - cell->leaves_size;
+  while (i < stride) {
+    value[i] =
+        (unsigned char)cell->elements[leaves + i - cell->nodes_size]->state;
+    ++i;
+  }
+  ++cell->entries_size;
+}
+
+/* looks up the listed cells, walking those not seen in their current state */
+
+static void fetx_cells_update(struct fetx *const fx) {
+  struct fetx_cells *const cells = fx->cells;
+  struct fetx_cell *cell = cells->update;
+  cells->update = 0;
+  while (cell != 0) {
+    struct fetx_cell *const next = cell->next_listed;
+    cell->is_listed = 0;
+    if (cell->flush != 0) {
+      size_t i = 0;
+      while (i < cell->table_size) {
+        cell->keys[i] = 0;
+        ++i;
+      }
+      cell->entries_size = 0;
+      cell->flush = 0;
+    }
+    const unsigned long long int key = fetx_cell_key(cell);
+    const size_t slot =
+        (cell->table_size != 0)
+            ? fetx_cell_slot(cell->keys, cell->table_size, key)
+            : 0;
+    if ((cell->table_size != 0) && (cell->keys[slot] == key)) {
+      ++cells->hits;
+      fetx_cell_apply(fx, cell,
+                      cell->values +
+                          (slot * (cell->nodes_size + cell->leaves_size)));
+    } else {
+      ++cells->misses;
+      fetx_cell_walk(fx, cell);
+      fetx_cell_store(cells, cell, key);
+    }
+    cell = next;
+  }
+}
+
+void fetx_input_nodes_update(struct fetx *const fx) {
   struct fetx_input_node *input_node = fx->input_nodes_update;
   while (input_node != 0) {
     fetx_input_node_update(fx, input_node);
@@ -490,22 +1761,92 @@ static void fetx_input_nodes_update(struct fetx *const fx) {
     input_node = input_node->next_listed;
   }
   fx->input_nodes_update = 0;
+  if ((fx->cells != 0) && (fx->cells->update != 0)) {
+    fetx_cells_update(fx);
+  }
+}
+
+/* resolves the listed levels lowest first so each FET is updated once per
+ * change of the inputs. Returns 0 if a FET was listed at or below a level
+ * already resolved, which can only happen when an input is driven
+ * FETX_UNSTABLE_MULTIPLE, to let the caller bound the time taken. */
+
+static unsigned char fetx_resolve_levels(struct fetx *const fx) {
+  while (fx->level < fx->levels_size) {
+    const size_t level = fx->level;
+    if (fx->levels[level] != 0) {
+      fx->fets_update = fx->levels[level];
+      fx->levels[level] = 0;
+      fetx_fets_update(fx);
+      fetx_input_nodes_update(fx);
+      if (fx->level < level) {
+        return 0;
+      }
+    }
+    if (fx->levels[fx->level] == 0) {
+      ++fx->level;
+    } else if (fx->level == level) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* resolves the next time a FET is due to switch, or the next step if nodes
+ * are listed, as without delays they are updated in the next step */
+
+static unsigned char fetx_resolve_wheel(struct fetx *const fx) {
+  struct fetx_wheel *const wheel = fx->wheel;
+  unsigned long long int time = fx->time + 1;
+  if ((fx->input_nodes_update == 0) &&
+      (fetx_wheel_next(wheel, &time) == 0)) {
+    /* an idle step */
+    ++fx->time;
+    wheel->now = fx->time + 1;
+    return 1;
+  }
+  size_t item = fetx_wheel_take(wheel, time);
+  fx->time = time;
+  /* kept in the order they were scheduled in */
+  struct fetx_fet **tail = &fx->fets_update;
+  while (item != FETX_WHEEL_NONE) {
+    struct fetx_fet *const fet = fx->fets + item;
+    *tail = fet;
+    tail = &fet->next_listed;
+    item = wheel->entries[item].next;
+  }
+  *tail = 0;
+  fetx_fets_update(fx);
+  fetx_input_nodes_update(fx);
+  return (wheel->size == 0) ? 1 : 0;
 }
 
 unsigned char fetx_resolve(struct fetx *const fx) {
+  if (fx->wheel != 0) {
+    return fetx_resolve_wheel(fx);
+  }
+  ++fx->time;
+  if (fx->levels != 0) {
+    return fetx_resolve_levels(fx);
+  }
   fetx_fets_update(fx);
   fetx_input_nodes_update(fx);
   return (fx->fets_update == 0) ? 1 : 0;
 }
 
+size_t fetx_multiple_drive_count(const struct fetx *const fx) {
+  return fx->multiple_driven;
+}
+
+/* \nodes is pointed at the indices of the multiply driven nodes, in no
+ * particular order, which are valid until the next state change */
+
+size_t fetx_multiple_drive_nodes(const struct fetx *const fx,
+                                 const size_t **const nodes) {
+  *nodes = fx->multiple;
+  return fx->multiple_driven;
+}
+
 size_t fetx_multiple_drive_detect(const struct fetx fx) {
-  size_t res = 0;
-  struct fetx_node *node = fx.nodes;
-  while (node != fx.nodes_limit) {
-    if (fetx_node_state_get(*node) == FETX_UNSTABLE_MULTIPLE) {
-      ++res;
-    }
-    ++node;
-  }
-  return res;
+  return fx.multiple_driven;
 }
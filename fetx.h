@@ -39,6 +39,7 @@ struct fetx_fetlist_fet {
   /* gate source drain, gate is connections[0] */
   size_t connections[3];
   enum fetx_fet_types type;
+  unsigned int delay; /* steps to switch after its gate changes, 0 for 1 */
 };
 
 struct fetx_fetlist {
@@ -46,37 +47,44 @@ struct fetx_fetlist {
   size_t size;
 };
 
-struct fetx_inter_node {
-  size_t index;
-  struct fetx_inter_fet **connections;
-  struct fetx_inter_fet **connections_limit;
-  struct fetx_inter_fet **control;
-  struct fetx_inter_fet **control_limit;
-};
+/* the FETs with their source or drain at each node, in compressed rows.
+ * Those of node n are edges[starts[n]] up to edges[starts[n + 1]], each with
+ * the node on the other side of the FET. */
 
-struct fetx_inter_fet {
-  size_t index;
-  /* the source and drain of the symmetrical FET */
-  struct fetx_inter_node *connections[2];
-  struct fetx_inter_node *control;
-  enum fetx_fet_types type;
+struct fetx_graph_edge {
+  size_t fet;
+  size_t node;
 };
 
-struct fetx_inter {
-  struct fetx_inter_node *nodes;
-  struct fetx_inter_fet *fets;
+struct fetx_graph {
+  size_t *starts; /* nodes_size + 1 */
+  struct fetx_graph_edge *edges; /* 2 per FET */
   size_t nodes_size;
-  size_t fets_size;
 };
 
 struct fetx_input_node;
+struct fetx_wheel;
+struct fetx_cell;
+
+/* the number of input paths in each state is held in 8 bits unless a node can
+ * have more paths than that, then the counts move to a side table in fx */
+
+union fetx_node_counts {
+  unsigned char narrow[4]; /* indexed with enum fetx_node_states */
+  unsigned int wide;       /* index of the counts in fx.wide_counts */
+};
 
 struct fetx_node {
-  size_t index;
-  size_t state_counts[4]; /* indexed with enum fetx_node_states */
   struct fetx_fet *control;
+  union fetx_node_counts counts;
+  unsigned char paths; /* input paths ending here, saturates at UCHAR_MAX */
+  unsigned int state_mask : 4; /* bit per nonzero count */
+  unsigned int is_wide : 1;
   unsigned int is_input : 1;
+  unsigned int is_supply : 1; /* paths end here rather than pass through */
   unsigned int flag : 1;
+  unsigned int is_traced : 1;
+  unsigned int is_trace_listed : 1;
 };
 
 struct fetx_fet {
@@ -87,7 +95,10 @@ struct fetx_fet {
   struct fetx_link *links;
   enum fetx_fet_states state;
   enum fetx_fet_types type;
+  size_t level; /* update order when levelised */
   unsigned int is_listed : 1;
+  unsigned int delay;
+  struct fetx_cell *cell; /* memoised cell it is in, or 0 */
 };
 
 struct fetx_link {
@@ -107,6 +118,45 @@ struct fetx_input_node {
   unsigned int is_listed : 1;
 };
 
+/* a channel connected cell between the supplies. Once its paths are updated
+ * the states of its nodes depend only on the states of its FETs, so each
+ * combination seen is kept and repeats are looked up rather than walked.
+ * Lookups leave the states of its paths stale, they are all updated again
+ * on a miss. */
+
+struct fetx_cell {
+  struct fetx_fet **fets;
+  struct fetx_node **nodes;
+  /* parents before children, then those ending at a supply */
+  struct fetx_input_node **elements;
+  size_t fets_size;
+  size_t nodes_size;
+  size_t elements_size;
+  size_t leaves_size; /* elements ending at a supply */
+  /* open addressed by the FET states + 1, 0 marks an empty slot. Each value
+   * is the state_mask of each node then the state of each leaf. */
+  unsigned long long int *keys;
+  unsigned char *values;
+  size_t table_size;
+  size_t entries_size;
+  struct fetx_cell *next_listed;
+  unsigned int is_listed : 1;
+  unsigned int flush : 1; /* a supply changed so the entries don't hold */
+};
+
+struct fetx_cells {
+  struct fetx_cell *cells;
+  size_t size;
+  struct fetx_cell *update; /* listed for the end of the step */
+  /* the arrays of every cell, in one block each */
+  struct fetx_fet **fets;
+  struct fetx_node **nodes;
+  struct fetx_input_node **elements;
+  unsigned long long int hits;
+  unsigned long long int misses;
+  size_t bytes; /* held by the tables */
+};
+
 struct fetx_node_arr {
   struct fetx_node **elements;
   struct fetx_node **limit;
@@ -115,12 +165,32 @@ struct fetx_node_arr {
 /* holds the nodes used for FET control, also the lists used at runtime */
 
 struct fetx {
+  /* when not 0, listed FETs are scheduled by their delays */
+  struct fetx_wheel *wheel;
+  /* when not 0, the cells whose node states are memoised */
+  struct fetx_cells *cells;
+  unsigned long long int time; /* of the last step resolved */
   struct fetx_node *nodes;
   struct fetx_node *nodes_limit;
   struct fetx_fet *fets;
   struct fetx_fet *fets_limit;
   struct fetx_fet *fets_update;
   struct fetx_input_node *input_nodes_update;
+  /* when not 0, listed FETs are held per level and resolved lowest first */
+  struct fetx_fet **levels;
+  size_t levels_size;
+  size_t level; /* no listed FETs below this level */
+  /* indices of the nodes in FETX_UNSTABLE_MULTIPLE and the position of each
+   * node in that array while it is on it */
+  size_t *multiple;
+  size_t *multiple_positions;
+  size_t multiple_driven;
+  /* traced nodes whose counts changed since the trace last sampled them */
+  size_t *traced_changed;
+  size_t traced_changed_size;
+  /* counts of the nodes with too many paths for 8 bit counts, 4 per node */
+  size_t *wide_counts;
+  size_t wide_counts_size;
 };
 
 /* shared util */
@@ -128,6 +198,7 @@ struct fetx {
 int fetx_check_multiply(size_t *const q, const size_t a, const size_t b);
 void *fetx_alloc(const size_t nmemb, const size_t size);
 void *fetx_calloc(const size_t nmemb, const size_t size);
+void *fetx_realloc(void *const ptr, const size_t nmemb, const size_t size);
 void fetx_dealloc(void *const ptr);
 
 /* FET list */
@@ -139,21 +210,56 @@ void fetx_fetlist_assign_fet(struct fetx_fetlist *const fl,
                              const struct fetx_fetlist_fet fet,
                              const size_t index);
 
-/* intermediate representation */
+/* source and drain graph, which replaces the fetx_inter intermediate
+ * representation */
 
-void fetx_inter_delete(struct fetx_inter fxi);
-int fetx_inter_init_fns(struct fetx_inter *const fxi,
-                        const struct fetx_fetlist fl, size_t nodes_size);
-int fetx_inter_init(struct fetx_inter *const fxi, const struct fetx_fetlist fl);
+void fetx_graph_delete(struct fetx_graph graph);
+int fetx_graph_init(struct fetx_graph *const graph,
+                    const struct fetx_fetlist fl, const size_t nodes_size);
+int fetx_graph_clone(struct fetx_graph *const graph,
+                     const struct fetx_graph src);
+size_t fetx_graph_bytes(const struct fetx_graph graph);
 
 /* runtime data */
 
 void fetx_delete(struct fetx fx);
-int fetx_init(struct fetx *const fx, const struct fetx_inter fxi);
+int fetx_init(struct fetx *const fx, const struct fetx_fetlist fl,
+              const size_t nodes_size);
+size_t fetx_bytes(const struct fetx *const fx);
 
 void fetx_input_delete(struct fetx_input_node path);
 int fetx_input_init(struct fetx_input_node *const path, struct fetx *const fx,
-                    const struct fetx_inter_node inter_node);
+                    const struct fetx_graph *const graph,
+                    const size_t node_index);
+int fetx_input_build(struct fetx_input_node *const path,
+                     const struct fetx *const fx,
+                     const struct fetx_graph *const graph,
+                     const size_t node_index, unsigned char *const on_path);
+int fetx_input_link(struct fetx *const fx,
+                    struct fetx_input_node *const path);
+size_t fetx_input_count(const struct fetx *const fx,
+                        const struct fetx_graph *const graph,
+                        const size_t node_index, const size_t cap,
+                        unsigned char *const on_path,
+                        struct fetx_graph_edge *const path);
+/* copies of a runtime with nothing listed, with the same states */
+int fetx_clone(struct fetx *const fx, const struct fetx *const src);
+int fetx_input_clone(struct fetx_input_node *const path, struct fetx *const fx,
+                     const struct fetx_input_node *const src_path,
+                     const struct fetx *const src_fx);
+/* returns 1 if the circuit has feedback and was left event driven */
+int fetx_levelise(struct fetx *const fx, struct fetx_input_node *const inputs,
+                  const size_t inputs_size);
+/* memoises the cells small enough to, ignored with delays. Every path must
+ * be built. */
+void fetx_cells_delete(struct fetx_cells *const cells);
+int fetx_cells_init(struct fetx *const fx,
+                    struct fetx_input_node *const roots,
+                    const size_t roots_size);
+/* returns 1 if the circuit has feedback, without changing it */
+int fetx_feedback_test(struct fetx *const fx,
+                       struct fetx_input_node *const inputs,
+                       const size_t inputs_size);
 
 /* runtime */
 
@@ -162,8 +268,19 @@ enum fetx_node_states fetx_node_state_get(const struct fetx_node node);
 void fetx_input_state_set(struct fetx *const fx,
                           struct fetx_input_node *const input_node,
                           const enum fetx_node_states new_state);
-/* returns 1 if the circuit has resolved, 0 otherwise */
+/* sets inputs without propagating them, fetx_input_nodes_update then
+ * propagates every input set this way in a single pass */
+void fetx_input_state_list(struct fetx *const fx,
+                           struct fetx_input_node *const input_node,
+                           const enum fetx_node_states new_state);
+void fetx_input_nodes_update(struct fetx *const fx);
+/* resolves the next step, which is the next time a FET switches when there
+ * are delays. Returns 1 if the circuit has resolved, 0 otherwise */
 unsigned char fetx_resolve(struct fetx *const fx);
+/* the multiply driven nodes are kept as states change */
+size_t fetx_multiple_drive_count(const struct fetx *const fx);
+size_t fetx_multiple_drive_nodes(const struct fetx *const fx,
+                                 const size_t **const nodes);
 size_t fetx_multiple_drive_detect(const struct fetx fx);
 
 #endif
@@ -0,0 +1,315 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_batch.h"
+
+#include <unistd.h>
+
+/* the runtime state is not known to match any row */
+#define FETX_BATCH_NO_ROW ((size_t)-1)
+
+/* takes a chunk from the front of the worker's own deque, or steals one from
+ * the back of another's. Returns -1 when there are none left anywhere, no
+ * chunks are added once the workers start. */
+
+static int fetx_batch_take(struct fetx_batch *const batch, const size_t index,
+                           size_t *const chunk) {
+  size_t k = 0;
+  while (k < batch->workers_size) {
+    struct fetx_batch_deque *const deque =
+        &batch->workers[(index + k) % batch->workers_size].deque;
+    int ret = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->head < deque->tail) {
+      if (k == 0) {
+        *chunk = deque->chunks[deque->head];
+        ++deque->head;
+      } else {
+        --deque->tail;
+        *chunk = deque->chunks[deque->tail];
+      }
+      ret = 0;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    if (ret == 0) {
+      return 0;
+    }
+    ++k;
+  }
+  return -1;
+}
+
+/* without feedback the settled state depends only on the current inputs, so
+ * a chunk can start from any runtime once the row before it has been
+ * settled, and then takes the same time as it would have sequentially. The
+ * first chunk needs the initial state. */
+
+static void fetx_batch_run_chunk(struct fetx_batch_worker *const worker,
+                                 struct fetx_batch_chunk *const chunk) {
+  const struct fetx_batch *const batch = worker->batch;
+  if ((worker->has_io != 0) && (chunk->start == 0) &&
+      (worker->next_row != 0)) {
+    fetx_io_delete(worker->io);
+    worker->has_io = 0;
+  }
+  if (worker->has_io == 0) {
+    if (fetx_io_clone(&worker->io, batch->io) != 0) {
+      chunk->errs = FETX_ERR_ALLOC;
+      return;
+    }
+    worker->has_io = 1;
+    worker->next_row = 0;
+  }
+
+  if ((chunk->start != 0) && (worker->next_row != chunk->start)) {
+    worker->next_row = FETX_BATCH_NO_ROW;
+    fetx_io_inputs_apply(&worker->io, batch->inputs.values[chunk->start - 1]);
+    unsigned long int time = 0;
+    unsigned long int now = worker->io.time;
+    while (fetx_io_resolve(&worker->io) == 0) {
+      time += worker->io.time - now;
+      now = worker->io.time;
+      if ((batch->time_limit != 0) && (time > batch->time_limit)) {
+        chunk->errs = FETX_ERR_TIMEOUT;
+        return;
+      }
+    }
+  }
+
+  const struct fetx_vector inputs = {
+      .values = batch->inputs.values + chunk->start,
+      .width = batch->inputs.width,
+      .length = chunk->end - chunk->start};
+  const struct fetx_vector outputs = {
+      .values = batch->outputs.values + chunk->start,
+      .width = batch->outputs.width,
+      .length = chunk->end - chunk->start};
+  chunk->errs = fetx_vector_sim_io(&chunk->res, outputs, &worker->io, inputs,
+                                   batch->time_limit);
+  worker->next_row =
+      (chunk->errs == FETX_ERR_NONE) ? chunk->end : FETX_BATCH_NO_ROW;
+}
+
+static void *fetx_batch_worker_run(void *const arg) {
+  struct fetx_batch_worker *const worker = arg;
+  size_t chunk;
+  while (fetx_batch_take(worker->batch, worker->index, &chunk) == 0) {
+    fetx_batch_run_chunk(worker, worker->batch->chunks + chunk);
+  }
+  if (worker->has_io != 0) {
+    fetx_io_delete(worker->io);
+    worker->has_io = 0;
+  }
+  return 0;
+}
+
+/* chunks can only be run independently when the circuit has no feedback and
+ * no input is driven FETX_UNSTABLE_MULTIPLE, which makes paths through both
+ * types of FET live. Returns -1 on an allocation error. */
+
+static int fetx_batch_splittable(struct fetx_io *const io,
+                                 const struct fetx_vector input_vector) {
+  size_t t = 0;
+  while (t < input_vector.length) {
+    size_t i = 0;
+    while (i < input_vector.width) {
+      if (input_vector.values[t][i] == FETX_UNSTABLE_MULTIPLE) {
+        return 0;
+      }
+      ++i;
+    }
+    ++t;
+  }
+  const int ret = fetx_feedback_test(&io->fx, io->inputs,
+                                     io->inputs_size + io->supplies_size);
+  return (ret < 0) ? -1 : ((ret == 0) ? 1 : 0);
+}
+
+static void fetx_batch_delete(struct fetx_batch batch) {
+  size_t i = 0;
+  while (i < batch.workers_size) {
+    fetx_dealloc(batch.workers[i].deque.chunks);
+    pthread_mutex_destroy(&batch.workers[i].deque.lock);
+    ++i;
+  }
+  fetx_dealloc(batch.workers);
+  fetx_dealloc(batch.chunks);
+}
+
+/* runs the chunks on the workers, returns -1 if none could be started */
+
+static int fetx_batch_run(struct fetx_batch *const batch) {
+  size_t started = 0;
+  while (started < batch->workers_size) {
+    struct fetx_batch_worker *const worker = batch->workers + started;
+    if (pthread_create(&worker->thread, 0, fetx_batch_worker_run, worker) !=
+        0) {
+      /* the chunks of workers that didn't start get stolen */
+      break;
+    }
+    ++started;
+  }
+  size_t i = 0;
+  while (i < started) {
+    pthread_join(batch->workers[i].thread, 0);
+    ++i;
+  }
+  return (started == 0) ? -1 : 0;
+}
+
+/* as fetx_vector_sim, the rows are split into chunks of \chunk_rows, or a
+ * size based on the number of workers if 0, that are simulated on
+ * \workers_size threads, or one per online CPU if 0. Circuits with feedback
+ * are simulated sequentially. The outputs and results are the same as
+ * fetx_vector_sim gives. */
+
+enum fetx_errs fetx_vector_sim_batch(struct fetx_sim_res *const res,
+                                     struct fetx_vector output_vector,
+                                     const struct fetx_netlist nl,
+                                     const struct fetx_io_opts opts,
+                                     const struct fetx_vector input_vector,
+                                     const unsigned long int time_limit,
+                                     const size_t workers_size,
+                                     const size_t chunk_rows) {
+  if ((input_vector.length != output_vector.length) ||
+      (input_vector.width != nl.inputs_size) ||
+      (output_vector.width != nl.outputs_size)) {
+    return FETX_ERR_PARAM;
+  }
+
+  /* the feedback test needs every path */
+  struct fetx_io_opts built = opts;
+  built.lazy = 0;
+  struct fetx_io io;
+  if (fetx_io_init_opts(&io, nl, built) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+
+  size_t workers = workers_size;
+  if (workers == 0) {
+    const long int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = (cpus > 0) ? (size_t)cpus : 1;
+  }
+  int split = 0;
+  if ((workers > 1) && (input_vector.length > 1)) {
+    split = fetx_batch_splittable(&io, input_vector);
+    if (split < 0) {
+      fetx_io_delete(io);
+      return FETX_ERR_ALLOC;
+    }
+  }
+  if (split == 0) {
+    const enum fetx_errs errs =
+        fetx_vector_sim_io(res, output_vector, &io, input_vector, time_limit);
+    fetx_io_delete(io);
+    return errs;
+  }
+
+  size_t rows = chunk_rows;
+  if (rows == 0) {
+    rows = input_vector.length / (workers * 4);
+    if (rows == 0) {
+      rows = 1;
+    }
+  }
+  struct fetx_batch batch = {.io = &io,
+                             .inputs = input_vector,
+                             .outputs = output_vector,
+                             .time_limit = time_limit,
+                             .workers_size = 0};
+  batch.chunks_size = (input_vector.length + rows - 1) / rows;
+  if (workers > batch.chunks_size) {
+    workers = batch.chunks_size;
+  }
+  batch.chunks = fetx_alloc(sizeof(*batch.chunks), batch.chunks_size);
+  batch.workers = fetx_alloc(sizeof(*batch.workers), workers);
+  if ((batch.chunks == 0) || (batch.workers == 0)) {
+    fetx_batch_delete(batch);
+    fetx_io_delete(io);
+    return FETX_ERR_ALLOC;
+  }
+  size_t i = 0;
+  while (i < batch.chunks_size) {
+    struct fetx_batch_chunk *const chunk = batch.chunks + i;
+    chunk->start = i * rows;
+    chunk->end = chunk->start + rows;
+    if (chunk->end > input_vector.length) {
+      chunk->end = input_vector.length;
+    }
+    /* chunks that fail or never run are summed as well */
+    chunk->res = (struct fetx_sim_res){.multiply_driven = 0, .time = 0};
+    chunk->errs = FETX_ERR_NONE;
+    ++i;
+  }
+
+  /* each worker starts with a contiguous run of chunks */
+  while (batch.workers_size < workers) {
+    struct fetx_batch_worker *const worker =
+        batch.workers + batch.workers_size;
+    const size_t first = (batch.workers_size * batch.chunks_size) / workers;
+    const size_t last =
+        ((batch.workers_size + 1) * batch.chunks_size) / workers;
+    worker->deque.chunks = fetx_alloc(sizeof(*worker->deque.chunks),
+                                      (last > first) ? last - first : 1);
+    if (worker->deque.chunks == 0) {
+      fetx_batch_delete(batch);
+      fetx_io_delete(io);
+      return FETX_ERR_ALLOC;
+    }
+    pthread_mutex_init(&worker->deque.lock, 0);
+    worker->deque.head = 0;
+    worker->deque.tail = 0;
+    while (worker->deque.tail < (last - first)) {
+      worker->deque.chunks[worker->deque.tail] = first + worker->deque.tail;
+      ++worker->deque.tail;
+    }
+    worker->batch = &batch;
+    worker->index = batch.workers_size;
+    worker->has_io = 0;
+    worker->next_row = 0;
+    ++batch.workers_size;
+  }
+
+  enum fetx_errs errs = FETX_ERR_NONE;
+  unsigned long int time = 0;
+  unsigned long int multiply_driven = 0;
+  if (fetx_batch_run(&batch) != 0) {
+    errs = FETX_ERR_TIMEOUT; /* fall back to a sequential run below */
+  }
+  i = 0;
+  while (i < batch.chunks_size) {
+    errs |= batch.chunks[i].errs;
+    time += batch.chunks[i].res.time;
+    multiply_driven += batch.chunks[i].res.multiply_driven;
+    ++i;
+  }
+  fetx_batch_delete(batch);
+
+  if ((errs & FETX_ERR_ALLOC) != 0) {
+    errs = FETX_ERR_ALLOC;
+  } else if ((errs != FETX_ERR_NONE) ||
+             ((time_limit != 0) && (time > time_limit))) {
+    /* the limit is on the total time, rerun to stop where a sequential run
+     * would */
+    errs =
+        fetx_vector_sim_io(res, output_vector, &io, input_vector, time_limit);
+  } else {
+    res->time = time;
+    res->multiply_driven = multiply_driven;
+  }
+  fetx_io_delete(io);
+  return errs;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_BATCH_H
+#define FETX_BATCH_H
+
+#include "fetx_vector.h"
+
+#include <pthread.h>
+
+/* simulates a vector split into chunks of rows across worker threads. Each
+ * worker takes chunks from the front of its own deque and steals from the
+ * back of the others' when it runs out. */
+
+struct fetx_batch_chunk {
+  size_t start; /* first row */
+  size_t end;   /* one past the last row */
+  struct fetx_sim_res res;
+  enum fetx_errs errs;
+};
+
+struct fetx_batch_deque {
+  size_t *chunks; /* indices into the chunk array */
+  size_t head;
+  size_t tail;
+  pthread_mutex_t lock;
+};
+
+struct fetx_batch;
+
+struct fetx_batch_worker {
+  struct fetx_batch *batch;
+  pthread_t thread;
+  size_t index;
+  struct fetx_batch_deque deque;
+  struct fetx_io io;
+  size_t next_row; /* row the runtime state continues to, 0 when initial */
+  unsigned char has_io;
+};
+
+struct fetx_batch {
+  const struct fetx_io *io; /* copied by the workers */
+  struct fetx_vector inputs;
+  struct fetx_vector outputs;
+  unsigned long int time_limit;
+  struct fetx_batch_chunk *chunks;
+  size_t chunks_size;
+  struct fetx_batch_worker *workers;
+  size_t workers_size;
+};
+
+enum fetx_errs fetx_vector_sim_batch(struct fetx_sim_res *const res,
+                                     struct fetx_vector output_vector,
+                                     const struct fetx_netlist nl,
+                                     const struct fetx_io_opts opts,
+                                     const struct fetx_vector input_vector,
+                                     const unsigned long int time_limit,
+                                     const size_t workers_size,
+                                     const size_t chunk_rows);
+
+#endif
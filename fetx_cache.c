@@ -0,0 +1,813 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_cache.h"
+#include "fetx_wheel.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/* bumped whenever the image layout or the runtime it describes changes */
+#define FETX_CACHE_VERSION 3
+
+/* seconds after which a temporary image is taken to be left by a writer
+ * that didn't finish */
+#define FETX_CACHE_TEMP_AGE (60 * 60)
+
+/* an image is the header followed by words, all indices: 4 per node, the
+ * controlled FET + 1, the paths, the wide counts + 1 and is_input with
+ * is_supply above it; 5 per FET, the control node, the next controlled FET
+ * + 1, the type, the level and the delay; 3 per input path element in
+ * preorder, the node, the FET + 1 and the parent element + 1, 0 for the root
+ * of each input then each supply in order; then the node of each output and
+ * the state of each supply. */
+
+struct fetx_cache_header {
+  char magic[8];
+  size_t word_size;
+  size_t version;
+  unsigned long long int key;
+  size_t nodes_size;
+  size_t fets_size;
+  size_t elements_size;
+  size_t inputs_size;
+  size_t outputs_size;
+  size_t supplies_size;
+  size_t levels_size;
+  size_t wide_size;
+};
+
+static const char fetx_cache_magic[8] = {'F', 'E', 'T', 'X',
+                                         'I', 'M', 'G', '\n'};
+
+/* 64 bit FNV-1a */
+
+static unsigned long long int fetx_cache_hash(unsigned long long int hash,
+                                              const void *const data,
+                                              const size_t size) {
+  const unsigned char *const bytes = data;
+  size_t i = 0;
+  while (i < size) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+    ++i;
+  }
+  return hash;
+}
+
+static unsigned long long int
+fetx_cache_hash_word(const unsigned long long int hash, const size_t word) {
+  return fetx_cache_hash(hash, &word, sizeof(word));
+}
+
+static unsigned long long int
+fetx_cache_hash_start(const char *const kind,
+                      const struct fetx_io_opts opts) {
+  unsigned long long int hash = 0xcbf29ce484222325ull;
+  hash = fetx_cache_hash(hash, kind, strlen(kind));
+  hash = fetx_cache_hash_word(hash, FETX_CACHE_VERSION);
+  hash = fetx_cache_hash_word(hash, opts.levelise);
+  return fetx_cache_hash_word(hash, opts.fold);
+}
+
+static unsigned long long int
+fetx_cache_key_netlist(const struct fetx_netlist nl,
+                       const struct fetx_io_opts opts) {
+  unsigned long long int hash = fetx_cache_hash_start("netlist", opts);
+  hash = fetx_cache_hash_word(hash, nl.nodes_size);
+  hash = fetx_cache_hash_word(hash, nl.fl.size);
+  size_t i = 0;
+  while (i < nl.fl.size) {
+    const struct fetx_fetlist_fet fet = nl.fl.fets[i];
+    hash = fetx_cache_hash_word(hash, fet.type);
+    hash = fetx_cache_hash_word(hash, fet.connections[0]);
+    hash = fetx_cache_hash_word(hash, fet.connections[1]);
+    hash = fetx_cache_hash_word(hash, fet.connections[2]);
+    hash = fetx_cache_hash_word(hash, fet.delay);
+    ++i;
+  }
+  hash = fetx_cache_hash_word(hash, nl.inputs_size);
+  i = 0;
+  while (i < nl.inputs_size) {
+    hash = fetx_cache_hash_word(hash, nl.inputs[i]);
+    ++i;
+  }
+  hash = fetx_cache_hash_word(hash, nl.outputs_size);
+  i = 0;
+  while (i < nl.outputs_size) {
+    hash = fetx_cache_hash_word(hash, nl.outputs[i]);
+    ++i;
+  }
+  hash = fetx_cache_hash_word(hash, nl.supplies_size);
+  i = 0;
+  while (i < nl.supplies_size) {
+    hash = fetx_cache_hash_word(hash, nl.supplies[i].node);
+    hash = fetx_cache_hash_word(hash, nl.supplies[i].state);
+    ++i;
+  }
+  return hash;
+}
+
+static enum fetx_errs fetx_cache_key_file(unsigned long long int *const key,
+                                          const char *const pathname,
+                                          const struct fetx_io_opts opts) {
+  FILE *const fd = fopen(pathname, "rb");
+  if (fd == 0) {
+    return FETX_ERR_FOPEN;
+  }
+  unsigned long long int hash = fetx_cache_hash_start("file", opts);
+  unsigned char buffer[4096];
+  size_t size;
+  while ((size = fread(buffer, 1, sizeof(buffer), fd)) != 0) {
+    hash = fetx_cache_hash(hash, buffer, size);
+  }
+  const int failed = ferror(fd);
+  if (fclose(fd) != 0) {
+    return FETX_ERR_FCLOSE;
+  }
+  if (failed != 0) {
+    return FETX_ERR_IO;
+  }
+  *key = hash;
+  return FETX_ERR_NONE;
+}
+
+/* returns the allocated path of the image for \key in \dir */
+
+static char *fetx_cache_path(const char *const dir,
+                             const unsigned long long int key) {
+  const size_t size = strlen(dir) + 22;
+  char *const path = fetx_alloc(sizeof(*path), size);
+  if (path != 0) {
+    snprintf(path, size, "%s/%016llx.fxi", dir, key);
+  }
+  return path;
+}
+
+/* image writing */
+
+static size_t fetx_cache_elements_count(const struct fetx_input_node *path) {
+  size_t count = 1;
+  const struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    count += fetx_cache_elements_count(output);
+    output = output->next_output;
+  }
+  return count;
+}
+
+static void fetx_cache_elements_put(size_t **const words,
+                                    size_t *const next_index,
+                                    const struct fetx *const fx,
+                                    const struct fetx_input_node *const path,
+                                    const size_t parent) {
+  const size_t index = *next_index;
+  ++*next_index;
+  size_t *const w = *words;
+  w[0] = path->node - fx->nodes;
+  w[1] = (parent != 0) ? (size_t)(path->link.fet - fx->fets) + 1 : 0;
+  w[2] = parent;
+  *words += 3;
+  const struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    fetx_cache_elements_put(words, next_index, fx, output, index + 1);
+    output = output->next_output;
+  }
+}
+
+/* writes the image of a newly built \io, nothing is written on failure */
+
+static void fetx_cache_image_write(const struct fetx_io *const io,
+                                   const char *const dir,
+                                   const char *const path,
+                                   const unsigned long long int key) {
+  const struct fetx *const fx = &io->fx;
+  struct fetx_cache_header header = {
+      .word_size = sizeof(size_t),
+      .version = FETX_CACHE_VERSION,
+      .key = key,
+      .nodes_size = fx->nodes_limit - fx->nodes,
+      .fets_size = fx->fets_limit - fx->fets,
+      .elements_size = 0,
+      .inputs_size = io->inputs_size,
+      .outputs_size = io->outputs_size,
+      .supplies_size = io->supplies_size,
+      .levels_size = (fx->levels != 0) ? fx->levels_size : 0,
+      .wide_size = fx->wide_counts_size};
+  size_t i = 0;
+  while (i < sizeof(header.magic)) {
+    header.magic[i] = fetx_cache_magic[i];
+    ++i;
+  }
+  i = 0;
+  while (i < (io->inputs_size + io->supplies_size)) {
+    header.elements_size += fetx_cache_elements_count(io->inputs + i);
+    ++i;
+  }
+  const size_t words_size = (header.nodes_size * 4) + (header.fets_size * 5) +
+                            (header.elements_size * 3) + header.outputs_size +
+                            header.supplies_size;
+  size_t *const words = fetx_alloc(sizeof(*words), words_size);
+  const size_t template_size = strlen(dir) + 13;
+  char *const template = fetx_alloc(sizeof(*template), template_size);
+  if ((words == 0) || (template == 0)) {
+    fetx_dealloc(words);
+    fetx_dealloc(template);
+    return;
+  }
+
+  size_t *w = words;
+  const struct fetx_node *node = fx->nodes;
+  while (node < fx->nodes_limit) {
+    w[0] = (node->control != 0) ? (size_t)(node->control - fx->fets) + 1 : 0;
+    w[1] = node->paths;
+    w[2] = (node->is_wide != 0) ? (size_t)node->counts.wide + 1 : 0;
+    w[3] = node->is_input | (node->is_supply << 1);
+    w += 4;
+    ++node;
+  }
+  const struct fetx_fet *fet = fx->fets;
+  while (fet < fx->fets_limit) {
+    w[0] = fet->control - fx->nodes;
+    w[1] = (fet->next_control != 0)
+               ? (size_t)(fet->next_control - fx->fets) + 1
+               : 0;
+    w[2] = fet->type;
+    w[3] = fet->level;
+    w[4] = fet->delay;
+    w += 5;
+    ++fet;
+  }
+  size_t next_index = 0;
+  i = 0;
+  while (i < (io->inputs_size + io->supplies_size)) {
+    fetx_cache_elements_put(&w, &next_index, fx, io->inputs + i, 0);
+    ++i;
+  }
+  i = 0;
+  while (i < io->outputs_size) {
+    *w = io->outputs[i] - fx->nodes;
+    ++w;
+    ++i;
+  }
+  i = 0;
+  while (i < io->supplies_size) {
+    *w = io->supply_states[i];
+    ++w;
+    ++i;
+  }
+
+  /* a unique temporary file renamed into place, readers only ever see whole
+   * images */
+  snprintf(template, template_size, "%s/.fxi.XXXXXX", dir);
+  const int fd = mkstemp(template);
+  if (fd >= 0) {
+    FILE *const file = fdopen(fd, "wb");
+    int ok = 0;
+    if (file != 0) {
+      ok = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+           (fwrite(words, sizeof(*words), words_size, file) == words_size);
+      ok = (fclose(file) == 0) && ok;
+    } else {
+      close(fd);
+    }
+    if ((ok == 0) || (rename(template, path) != 0)) {
+      unlink(template);
+    }
+  }
+  fetx_dealloc(words);
+  fetx_dealloc(template);
+}
+
+/* image loading */
+
+static int fetx_cache_magic_check(const struct fetx_cache_header *const h) {
+  size_t i = 0;
+  while (i < sizeof(h->magic)) {
+    if (h->magic[i] != fetx_cache_magic[i]) {
+      return -1;
+    }
+    ++i;
+  }
+  return 0;
+}
+
+static int fetx_cache_image_check(const struct fetx_cache_header *const h,
+                                  const size_t *const words) {
+  const size_t *w = words;
+  size_t i = 0;
+  while (i < h->nodes_size) {
+    if ((w[0] > h->fets_size) || (w[1] > UCHAR_MAX) ||
+        (w[2] > h->wide_size) || (w[3] > 3)) {
+      return -1;
+    }
+    w += 4;
+    ++i;
+  }
+  i = 0;
+  while (i < h->fets_size) {
+    if ((w[0] >= h->nodes_size) || (w[1] > h->fets_size) || (w[2] > 1) ||
+        ((w[3] != 0) && (w[3] >= h->levels_size)) || (w[4] == 0) ||
+        (w[4] > UINT_MAX)) {
+      return -1;
+    }
+    w += 5;
+    ++i;
+  }
+  size_t roots = 0;
+  i = 0;
+  while (i < h->elements_size) {
+    if ((w[0] >= h->nodes_size) || (w[1] > h->fets_size) || (w[2] > i) ||
+        ((w[1] == 0) != (w[2] == 0))) {
+      return -1;
+    }
+    roots += (w[2] == 0) ? 1 : 0;
+    w += 3;
+    ++i;
+  }
+  if (roots != (h->inputs_size + h->supplies_size)) {
+    return -1;
+  }
+  i = 0;
+  while (i < h->outputs_size) {
+    if (w[i] >= h->nodes_size) {
+      return -1;
+    }
+    ++i;
+  }
+  w += h->outputs_size;
+  i = 0;
+  while (i < h->supplies_size) {
+    if ((w[i] != FETX_LOW) && (w[i] != FETX_HIGH)) {
+      return -1;
+    }
+    ++i;
+  }
+  return 0;
+}
+
+static int fetx_cache_fx_alloc(struct fetx *const fx,
+                               const struct fetx_cache_header *const h) {
+  fx->nodes = fetx_alloc(sizeof(*fx->nodes), h->nodes_size);
+  fx->fets = fetx_alloc(sizeof(*fx->fets), h->fets_size);
+  fx->multiple = fetx_alloc(sizeof(*fx->multiple), h->nodes_size);
+  fx->multiple_positions =
+      fetx_alloc(sizeof(*fx->multiple_positions), h->nodes_size);
+  fx->levels = (h->levels_size != 0)
+                   ? fetx_calloc(h->levels_size, sizeof(*fx->levels))
+                   : 0;
+  fx->wide_counts =
+      (h->wide_size != 0)
+          ? fetx_calloc(h->wide_size * 4, sizeof(*fx->wide_counts))
+          : 0;
+  if (((fx->nodes == 0) && (h->nodes_size != 0)) ||
+      ((fx->fets == 0) && (h->fets_size != 0)) ||
+      ((fx->multiple == 0) && (h->nodes_size != 0)) ||
+      ((fx->multiple_positions == 0) && (h->nodes_size != 0)) ||
+      ((fx->levels == 0) && (h->levels_size != 0)) ||
+      ((fx->wide_counts == 0) && (h->wide_size != 0))) {
+    fetx_dealloc(fx->nodes);
+    fetx_dealloc(fx->fets);
+    fetx_dealloc(fx->multiple);
+    fetx_dealloc(fx->multiple_positions);
+    fetx_dealloc(fx->levels);
+    fetx_dealloc(fx->wide_counts);
+    return -1;
+  }
+  fx->nodes_limit = fx->nodes + h->nodes_size;
+  fx->fets_limit = fx->fets + h->fets_size;
+  fx->wheel = 0;
+  fx->cells = 0;
+  fx->time = 0;
+  fx->fets_update = 0;
+  fx->input_nodes_update = 0;
+  fx->levels_size = h->levels_size;
+  fx->level = h->levels_size;
+  fx->multiple_driven = 0;
+  fx->traced_changed = 0;
+  fx->traced_changed_size = 0;
+  fx->wide_counts_size = h->wide_size;
+  return 0;
+}
+
+static void fetx_cache_element_init(struct fetx_input_node *const el,
+                                    struct fetx *const fx,
+                                    const size_t *const w) {
+  el->node = fx->nodes + w[0];
+  el->state = FETX_UNDRIVEN;
+  el->outputs = 0;
+  el->next_output = 0;
+  el->next_listed = 0;
+  el->is_listed = 0;
+  el->link.input = 0;
+}
+
+/* builds \io from a checked image */
+
+static enum fetx_errs
+fetx_cache_image_build(struct fetx_io *const io,
+                       const struct fetx_cache_header *const h,
+                       const size_t *const words) {
+  io->inputs = 0;
+  io->outputs = 0;
+  io->inputs_size = 0;
+  io->outputs_size = 0;
+  io->supplies_size = 0;
+  io->supply_states = 0;
+  io->trace = 0;
+  io->time = 0;
+  io->lazy = 0;
+  io->stats = (struct fetx_io_stats){.inputs_built =
+                                         h->inputs_size + h->supplies_size,
+                                     .elements_built = h->elements_size};
+  struct fetx *const fx = &io->fx;
+  if (fetx_cache_fx_alloc(fx, h) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+
+  const size_t *w = words;
+  size_t i = 0;
+  while (i < h->nodes_size) {
+    struct fetx_node *const node = fx->nodes + i;
+    node->control = (w[0] != 0) ? fx->fets + (w[0] - 1) : 0;
+    node->counts.narrow[FETX_LOW] = 0;
+    node->counts.narrow[FETX_HIGH] = 0;
+    node->counts.narrow[FETX_UNSTABLE_LOW] = 0;
+    node->counts.narrow[FETX_UNSTABLE_HIGH] = 0;
+    if (w[2] != 0) {
+      node->counts.wide = (unsigned int)(w[2] - 1);
+    }
+    node->paths = (unsigned char)w[1];
+    node->state_mask = 0;
+    node->is_wide = (w[2] != 0) ? 1 : 0;
+    node->is_input = (unsigned int)(w[3] & 1);
+    node->is_supply = (unsigned int)(w[3] >> 1);
+    node->flag = 0;
+    node->is_traced = 0;
+    node->is_trace_listed = 0;
+    w += 4;
+    ++i;
+  }
+  i = 0;
+  while (i < h->fets_size) {
+    struct fetx_fet *const fet = fx->fets + i;
+    fet->index = i;
+    fet->control = fx->nodes + w[0];
+    fet->next_control = (w[1] != 0) ? fx->fets + (w[1] - 1) : 0;
+    fet->next_listed = 0;
+    fet->links = 0;
+    fet->state = FETX_UNSTABLE;
+    fet->type = (enum fetx_fet_types)w[2];
+    fet->level = w[3];
+    fet->is_listed = 0;
+    fet->cell = 0;
+    fet->delay = (unsigned int)w[4];
+    if ((fet->delay > 1) && (fx->wheel == 0)) {
+      fx->wheel = fetx_wheel_new(h->fets_size, 1);
+      if (fx->wheel == 0) {
+        fetx_io_delete(*io);
+        return FETX_ERR_ALLOC;
+      }
+    }
+    w += 5;
+    ++i;
+  }
+
+  io->inputs =
+      fetx_alloc(sizeof(*io->inputs), h->inputs_size + h->supplies_size);
+  io->outputs = fetx_alloc(sizeof(*io->outputs), h->outputs_size);
+  io->supply_states =
+      fetx_alloc(sizeof(*io->supply_states), h->supplies_size);
+  struct fetx_input_node **const made =
+      fetx_alloc(sizeof(*made), h->elements_size);
+  struct fetx_input_node **const last =
+      fetx_calloc(h->elements_size, sizeof(*last));
+  if (((io->inputs == 0) && ((h->inputs_size + h->supplies_size) != 0)) ||
+      ((io->outputs == 0) && (h->outputs_size != 0)) ||
+      ((io->supply_states == 0) && (h->supplies_size != 0)) ||
+      ((made == 0) && (h->elements_size != 0)) ||
+      ((last == 0) && (h->elements_size != 0))) {
+    fetx_dealloc(made);
+    fetx_dealloc(last);
+    fetx_io_delete(*io);
+    return FETX_ERR_ALLOC;
+  }
+
+  /* the roots first so a partly built io can be deleted */
+  const size_t *const elements = w;
+  size_t roots = 0;
+  i = 0;
+  while (i < h->elements_size) {
+    if (elements[(i * 3) + 2] == 0) {
+      struct fetx_input_node *const root = io->inputs + roots;
+      fetx_cache_element_init(root, fx, elements + (i * 3));
+      made[i] = root;
+      ++roots;
+    }
+    ++i;
+  }
+  io->inputs_size = h->inputs_size;
+  io->supplies_size = h->supplies_size;
+  i = 0;
+  while (i < h->elements_size) {
+    const size_t *const e = elements + (i * 3);
+    if (e[2] != 0) {
+      struct fetx_input_node *const el = fetx_alloc(sizeof(*el), 1);
+      if (el == 0) {
+        fetx_dealloc(made);
+        fetx_dealloc(last);
+        fetx_io_delete(*io);
+        return FETX_ERR_ALLOC;
+      }
+      struct fetx_input_node *const parent = made[e[2] - 1];
+      struct fetx_fet *const fet = fx->fets + (e[1] - 1);
+      fetx_cache_element_init(el, fx, e);
+      el->link.input = parent;
+      el->link.output = el;
+      el->link.fet = fet;
+      el->link.next = fet->links;
+      fet->links = &el->link;
+      if (last[e[2] - 1] != 0) {
+        last[e[2] - 1]->next_output = el;
+      } else {
+        parent->outputs = el;
+      }
+      last[e[2] - 1] = el;
+      made[i] = el;
+    }
+    ++i;
+  }
+  fetx_dealloc(made);
+  fetx_dealloc(last);
+
+  w = elements + (h->elements_size * 3);
+  i = 0;
+  while (i < h->outputs_size) {
+    io->outputs[i] = fx->nodes + w[i];
+    ++i;
+  }
+  io->outputs_size = i;
+  w += h->outputs_size;
+  i = 0;
+  while (i < h->supplies_size) {
+    io->supply_states[i] = (enum fetx_node_states)w[i];
+    ++i;
+  }
+  return FETX_ERR_NONE;
+}
+
+/* returns FETX_ERR_FOPEN if there is no image, FETX_ERR_FFORMAT if it is not
+ * valid for \key */
+
+static enum fetx_errs fetx_cache_image_load(struct fetx_io *const io,
+                                            const char *const path,
+                                            const unsigned long long int key) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return FETX_ERR_FOPEN;
+  }
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+      ((size_t)st.st_size < sizeof(struct fetx_cache_header))) {
+    close(fd);
+    return FETX_ERR_FFORMAT;
+  }
+  const size_t size = st.st_size;
+  void *const map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return FETX_ERR_IO;
+  }
+
+  const struct fetx_cache_header *const h = map;
+  const size_t *const words =
+      (const size_t *)((const char *)map + sizeof(*h));
+  const size_t words_size = (size - sizeof(*h)) / sizeof(*words);
+  enum fetx_errs errs = FETX_ERR_FFORMAT;
+  /* each count is bounded by the words so the sums can't overflow */
+  if ((fetx_cache_magic_check(h) == 0) &&
+      (h->word_size == sizeof(size_t)) && (h->version == FETX_CACHE_VERSION) &&
+      (h->key == key) && (h->nodes_size <= words_size) &&
+      (h->fets_size <= words_size) && (h->elements_size <= words_size) &&
+      (h->outputs_size <= words_size) && (h->inputs_size <= words_size) &&
+      (h->supplies_size <= words_size) &&
+      (h->wide_size <= words_size) && (h->levels_size <= h->fets_size + 1) &&
+      (((size - sizeof(*h)) % sizeof(*words)) == 0) &&
+      (((h->nodes_size * 4) + (h->fets_size * 5) + (h->elements_size * 3) +
+        h->outputs_size + h->supplies_size) == words_size) &&
+      (fetx_cache_image_check(h, words) == 0)) {
+    errs = fetx_cache_image_build(io, h, words);
+  }
+  munmap(map, size);
+  return errs;
+}
+
+/* eviction */
+
+struct fetx_cache_entry {
+  char *path;
+  off_t size;
+  time_t used;
+};
+
+static int fetx_cache_entry_compare(const void *const a, const void *const b) {
+  const struct fetx_cache_entry *const ea = a;
+  const struct fetx_cache_entry *const eb = b;
+  return (ea->used < eb->used) ? -1 : ((ea->used > eb->used) ? 1 : 0);
+}
+
+/* removes stale temporary images, then if there is a limit the least
+ * recently used images, other than \keep, until the directory is within it.
+ * Other processes may be doing the same, so files that have already gone are
+ * skipped. */
+
+static void fetx_cache_evict(const struct fetx_cache cache,
+                             const char *const keep) {
+  DIR *const dir = opendir(cache.dir);
+  if (dir == 0) {
+    return;
+  }
+  struct fetx_cache_entry *entries = 0;
+  size_t entries_size = 0;
+  unsigned long long int total = 0;
+  const time_t now = time(0);
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != 0) {
+    const size_t len = strlen(ent->d_name);
+    const int is_temp = (strncmp(ent->d_name, ".fxi.", 5) == 0);
+    if ((is_temp == 0) &&
+        ((len < 5) || (strcmp(ent->d_name + len - 4, ".fxi") != 0) ||
+         (ent->d_name[0] == '.'))) {
+      continue;
+    }
+    struct fetx_cache_entry *const grown =
+        fetx_realloc(entries, entries_size + 1, sizeof(*entries));
+    char *const path = fetx_alloc(sizeof(*path), strlen(cache.dir) + len + 2);
+    if ((grown == 0) || (path == 0)) {
+      entries = (grown != 0) ? grown : entries;
+      fetx_dealloc(path);
+      break;
+    }
+    entries = grown;
+    sprintf(path, "%s/%s", cache.dir, ent->d_name);
+    struct stat st;
+    if (stat(path, &st) != 0) {
+      fetx_dealloc(path);
+      continue;
+    }
+    if (is_temp != 0) {
+      /* one still being written takes space but can't be removed */
+      if ((now - st.st_mtime) > FETX_CACHE_TEMP_AGE) {
+        unlink(path);
+      } else {
+        total += st.st_size;
+      }
+      fetx_dealloc(path);
+      continue;
+    }
+    entries[entries_size].path = path;
+    entries[entries_size].size = st.st_size;
+    entries[entries_size].used = st.st_mtime;
+    ++entries_size;
+    total += st.st_size;
+  }
+  closedir(dir);
+
+  qsort(entries, entries_size, sizeof(*entries), fetx_cache_entry_compare);
+  size_t i = 0;
+  while (i < entries_size) {
+    if ((cache.size_limit != 0) && (total > cache.size_limit) &&
+        (strcmp(entries[i].path, keep) != 0) &&
+        (unlink(entries[i].path) == 0)) {
+      total -= entries[i].size;
+    }
+    fetx_dealloc(entries[i].path);
+    ++i;
+  }
+  fetx_dealloc(entries);
+}
+
+/* loads the image for \key into \io, marking it used. Returns
+ * FETX_ERR_FOPEN if there is no usable image. */
+
+static enum fetx_errs fetx_cache_lookup(struct fetx_io *const io,
+                                        const char *const path,
+                                        const unsigned long long int key) {
+  const enum fetx_errs errs = fetx_cache_image_load(io, path, key);
+  if (errs == FETX_ERR_NONE) {
+    utimes(path, 0);
+    return FETX_ERR_NONE;
+  }
+  return (errs == FETX_ERR_ALLOC) ? FETX_ERR_ALLOC : FETX_ERR_FOPEN;
+}
+
+static void fetx_cache_store(const struct fetx_io *const io,
+                             const struct fetx_cache cache,
+                             const char *const path,
+                             const unsigned long long int key) {
+  fetx_cache_image_write(io, cache.dir, path, key);
+  fetx_cache_evict(cache, path);
+}
+
+/* images don't hold the memoised cells, they are found once loaded */
+
+static enum fetx_errs fetx_cache_memo(struct fetx_io *const io,
+                                      const struct fetx_io_opts opts,
+                                      const enum fetx_errs errs) {
+  if ((errs != FETX_ERR_NONE) || (opts.memo == 0)) {
+    return errs;
+  }
+  if (fetx_io_memo_init(io) != 0) {
+    fetx_io_delete(*io);
+    return FETX_ERR_ALLOC;
+  }
+  return FETX_ERR_NONE;
+}
+
+/* as fetx_io_init_opts, using the image of \nl in \cache if there is one,
+ * otherwise building the runtime and storing its image. Failing to store the
+ * image is not an error. Images hold every path so lazy building is off. */
+
+enum fetx_errs fetx_cache_io_init(struct fetx_io *const io,
+                                  const struct fetx_cache cache,
+                                  const struct fetx_netlist nl,
+                                  const struct fetx_io_opts opts) {
+  const struct fetx_io_opts built = {.levelise = opts.levelise,
+                                     .fold = opts.fold};
+  const unsigned long long int key = fetx_cache_key_netlist(nl, built);
+  char *const path = fetx_cache_path(cache.dir, key);
+  if (path == 0) {
+    return FETX_ERR_ALLOC;
+  }
+  enum fetx_errs errs = fetx_cache_lookup(io, path, key);
+  if (errs == FETX_ERR_NONE) {
+    io->stats.folded = built.fold;
+  } else if (errs == FETX_ERR_FOPEN) {
+    errs = (fetx_io_init_opts(io, nl, built) != 0) ? FETX_ERR_ALLOC
+                                                    : FETX_ERR_NONE;
+    if (errs == FETX_ERR_NONE) {
+      fetx_cache_store(io, cache, path, key);
+    }
+  }
+  fetx_dealloc(path);
+  return fetx_cache_memo(io, opts, errs);
+}
+
+/* as fetx_cache_io_init for the netlist file at \pathname, keyed by the
+ * contents of the file so that it is only parsed when there is no image */
+
+enum fetx_errs fetx_cache_io_from_file(struct fetx_io *const io,
+                                       const struct fetx_cache cache,
+                                       const char *const pathname,
+                                       const struct fetx_io_opts opts) {
+  const struct fetx_io_opts built = {.levelise = opts.levelise,
+                                     .fold = opts.fold};
+  unsigned long long int key;
+  enum fetx_errs errs = fetx_cache_key_file(&key, pathname, built);
+  if (errs != FETX_ERR_NONE) {
+    return errs;
+  }
+  char *const path = fetx_cache_path(cache.dir, key);
+  if (path == 0) {
+    return FETX_ERR_ALLOC;
+  }
+  errs = fetx_cache_lookup(io, path, key);
+  if (errs == FETX_ERR_NONE) {
+    io->stats.folded = built.fold;
+  } else if (errs == FETX_ERR_FOPEN) {
+    struct fetx_netlist nl;
+    errs = fetx_netlist_from_file(&nl, pathname);
+    if (errs == FETX_ERR_NONE) {
+      errs = (fetx_io_init_opts(io, nl, built) != 0) ? FETX_ERR_ALLOC
+                                                      : FETX_ERR_NONE;
+      fetx_netlist_delete(nl);
+      if (errs == FETX_ERR_NONE) {
+        fetx_cache_store(io, cache, path, key);
+      }
+    }
+  }
+  fetx_dealloc(path);
+  return fetx_cache_memo(io, opts, errs);
+}
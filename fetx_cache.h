@@ -0,0 +1,43 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_CACHE_H
+#define FETX_CACHE_H
+
+#include "fetx_io.h"
+
+/* compiled runtimes kept in a directory as images keyed by a hash of the
+ * netlist and options, loaded instead of building the runtime again. Images
+ * are written to a temporary file then renamed into place so concurrent
+ * writers are safe. When size_limit is not 0 the least recently used images
+ * are removed to keep the directory under it, in bytes. Temporary files left
+ * by writers that didn't finish are removed once they are an hour old. */
+
+struct fetx_cache {
+  const char *dir;
+  unsigned long long int size_limit;
+};
+
+enum fetx_errs fetx_cache_io_init(struct fetx_io *const io,
+                                  const struct fetx_cache cache,
+                                  const struct fetx_netlist nl,
+                                  const struct fetx_io_opts opts);
+enum fetx_errs fetx_cache_io_from_file(struct fetx_io *const io,
+                                       const struct fetx_cache cache,
+                                       const char *const pathname,
+                                       const struct fetx_io_opts opts);
+
+#endif
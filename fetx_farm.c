@@ -0,0 +1,280 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE /* for pthread_setaffinity_np and sched_getaffinity */
+#endif
+
+#include "fetx_farm.h"
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/* each worker owns the instances whose index is its own modulo the number of
+ * workers, it copies them when it starts and runs their jobs in order */
+
+static void *fetx_farm_worker_run(void *const arg) {
+  struct fetx_farm_worker *const worker = arg;
+  struct fetx_farm *const farm = worker->farm;
+
+#ifdef __linux__
+  if (worker->cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(worker->cpu, &cpus);
+    /* placement is only a hint, run unpinned if it fails */
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+
+  enum fetx_errs errs = FETX_ERR_NONE;
+  size_t i = worker->index;
+  while (i < farm->instances_size) {
+    struct fetx_farm_instance *const instance = farm->instances + i;
+    if (fetx_io_clone(&instance->io, &farm->io) != 0) {
+      errs = FETX_ERR_ALLOC;
+      break;
+    }
+    instance->is_copied = 1;
+    i += farm->workers_size;
+  }
+
+  pthread_mutex_lock(&farm->lock);
+  farm->errs |= errs;
+  --farm->starting;
+  if (farm->starting == 0) {
+    pthread_cond_broadcast(&farm->done);
+  }
+
+  /* the instance after the last one served is checked first */
+  size_t next = worker->index;
+  while (1) {
+    struct fetx_farm_instance *instance = 0;
+    size_t n = 0;
+    while ((instance == 0) && (n < farm->instances_size)) {
+      if (farm->instances[next].jobs != 0) {
+        instance = farm->instances + next;
+      }
+      next += farm->workers_size;
+      if (next >= farm->instances_size) {
+        next = worker->index;
+      }
+      n += farm->workers_size;
+    }
+    if (instance != 0) {
+      struct fetx_farm_job *const job = instance->jobs;
+      instance->jobs = job->next;
+      if (instance->jobs == 0) {
+        instance->jobs_last = 0;
+      }
+      pthread_mutex_unlock(&farm->lock);
+      job->errs = fetx_vector_sim_io(&job->res, job->outputs, &instance->io,
+                                     job->inputs, job->time_limit);
+      pthread_mutex_lock(&farm->lock);
+      --farm->pending;
+      if (farm->pending == 0) {
+        pthread_cond_broadcast(&farm->done);
+      }
+    } else if (farm->quit != 0) {
+      break;
+    } else {
+      pthread_cond_wait(&farm->work, &farm->lock);
+    }
+  }
+  pthread_mutex_unlock(&farm->lock);
+  return 0;
+}
+
+/* picks a CPU for each worker from those the process may run on, in order,
+ * so that consecutive workers share a package where the numbering allows */
+
+static void fetx_farm_workers_place(struct fetx_farm *const farm) {
+  size_t i = 0;
+  while (i < farm->workers_size) {
+    farm->workers[i].cpu = -1;
+    ++i;
+  }
+#ifdef __linux__
+  cpu_set_t cpus;
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+    return;
+  }
+  const int count = CPU_COUNT(&cpus);
+  if (count <= 0) {
+    return;
+  }
+  i = 0;
+  while (i < farm->workers_size) {
+    int nth = (int)(i % (size_t)count);
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE) {
+      if ((CPU_ISSET(cpu, &cpus) != 0) && (nth-- == 0)) {
+        farm->workers[i].cpu = cpu;
+        break;
+      }
+      ++cpu;
+    }
+    ++i;
+  }
+#endif
+}
+
+static void fetx_farm_free(struct fetx_farm *const farm) {
+  size_t i = 0;
+  while (i < farm->instances_size) {
+    if (farm->instances[i].is_copied != 0) {
+      fetx_io_delete(farm->instances[i].io);
+    }
+    ++i;
+  }
+  fetx_dealloc(farm->instances);
+  fetx_dealloc(farm->workers);
+  fetx_io_delete(farm->io);
+  pthread_mutex_destroy(&farm->lock);
+  pthread_cond_destroy(&farm->work);
+  pthread_cond_destroy(&farm->done);
+}
+
+/* stops the first \started workers */
+
+static void fetx_farm_stop(struct fetx_farm *const farm, const size_t started) {
+  pthread_mutex_lock(&farm->lock);
+  farm->quit = 1;
+  pthread_cond_broadcast(&farm->work);
+  pthread_mutex_unlock(&farm->lock);
+  size_t i = 0;
+  while (i < started) {
+    pthread_join(farm->workers[i].thread, 0);
+    ++i;
+  }
+}
+
+/* compiles \nl once and starts \workers_size threads sharing
+ * \instances_size copies of it, 0 workers uses one per online CPU up to the
+ * number of instances */
+
+enum fetx_errs fetx_farm_init(struct fetx_farm *const farm,
+                              const struct fetx_netlist nl,
+                              const struct fetx_io_opts opts,
+                              const size_t instances_size,
+                              const size_t workers_size) {
+  if (instances_size == 0) {
+    return FETX_ERR_PARAM;
+  }
+  size_t workers = workers_size;
+  if (workers == 0) {
+    const long int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = (cpus > 0) ? (size_t)cpus : 1;
+  }
+  if (workers > instances_size) {
+    workers = instances_size;
+  }
+
+  if (fetx_io_init_opts(&farm->io, nl, opts) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+  farm->instances = fetx_calloc(instances_size, sizeof(*farm->instances));
+  farm->workers = fetx_alloc(sizeof(*farm->workers), workers);
+  if ((farm->instances == 0) || (farm->workers == 0)) {
+    fetx_dealloc(farm->instances);
+    fetx_dealloc(farm->workers);
+    fetx_io_delete(farm->io);
+    return FETX_ERR_ALLOC;
+  }
+  farm->instances_size = instances_size;
+  farm->workers_size = workers;
+  farm->pending = 0;
+  farm->starting = workers;
+  farm->errs = FETX_ERR_NONE;
+  farm->quit = 0;
+  pthread_mutex_init(&farm->lock, 0);
+  pthread_cond_init(&farm->work, 0);
+  pthread_cond_init(&farm->done, 0);
+  fetx_farm_workers_place(farm);
+
+  size_t i = 0;
+  while (i < workers) {
+    struct fetx_farm_worker *const worker = farm->workers + i;
+    worker->farm = farm;
+    worker->index = i;
+    if (pthread_create(&worker->thread, 0, fetx_farm_worker_run, worker) !=
+        0) {
+      fetx_farm_stop(farm, i);
+      fetx_farm_free(farm);
+      return FETX_ERR_ALLOC;
+    }
+    ++i;
+  }
+
+  /* wait for the copies */
+  pthread_mutex_lock(&farm->lock);
+  while (farm->starting != 0) {
+    pthread_cond_wait(&farm->done, &farm->lock);
+  }
+  const enum fetx_errs errs = farm->errs;
+  pthread_mutex_unlock(&farm->lock);
+  if (errs != FETX_ERR_NONE) {
+    fetx_farm_stop(farm, workers);
+    fetx_farm_free(farm);
+  }
+  return errs;
+}
+
+/* queues \job to run on \instance after any jobs already queued for it, the
+ * job must stay valid until fetx_farm_wait returns */
+
+void fetx_farm_submit(struct fetx_farm *const farm, const size_t instance,
+                      struct fetx_farm_job *const job) {
+  job->next = 0;
+  job->errs = FETX_ERR_NONE;
+  pthread_mutex_lock(&farm->lock);
+  struct fetx_farm_instance *const inst = farm->instances + instance;
+  if (inst->jobs_last != 0) {
+    inst->jobs_last->next = job;
+  } else {
+    inst->jobs = job;
+  }
+  inst->jobs_last = job;
+  ++farm->pending;
+  pthread_cond_broadcast(&farm->work);
+  pthread_mutex_unlock(&farm->lock);
+}
+
+/* waits until every submitted job has run */
+
+void fetx_farm_wait(struct fetx_farm *const farm) {
+  pthread_mutex_lock(&farm->lock);
+  while (farm->pending != 0) {
+    pthread_cond_wait(&farm->done, &farm->lock);
+  }
+  pthread_mutex_unlock(&farm->lock);
+}
+
+/* the runtime of \instance, only to be used while no jobs are pending */
+
+struct fetx_io *fetx_farm_instance(struct fetx_farm *const farm,
+                                   const size_t instance) {
+  return &farm->instances[instance].io;
+}
+
+void fetx_farm_delete(struct fetx_farm *const farm) {
+  fetx_farm_wait(farm);
+  fetx_farm_stop(farm, farm->workers_size);
+  fetx_farm_free(farm);
+}
@@ -0,0 +1,83 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_FARM_H
+#define FETX_FARM_H
+
+#include "fetx_vector.h"
+
+#include <pthread.h>
+
+/* runs many copies of one circuit on a pool of worker threads. The netlist
+ * is compiled once and each instance is copied from it by the worker that
+ * owns it, so its memory is local to the worker. Jobs for an instance run in
+ * the order they were submitted, so results don't depend on scheduling. */
+
+struct fetx_farm_job {
+  /* set before submitting */
+  struct fetx_vector inputs;
+  struct fetx_vector outputs;
+  unsigned long int time_limit;
+  /* set once the job has run */
+  struct fetx_sim_res res;
+  enum fetx_errs errs;
+  struct fetx_farm_job *next;
+};
+
+struct fetx_farm_instance {
+  struct fetx_io io;
+  struct fetx_farm_job *jobs; /* pending, oldest first */
+  struct fetx_farm_job *jobs_last;
+  unsigned char is_copied;
+};
+
+struct fetx_farm;
+
+struct fetx_farm_worker {
+  struct fetx_farm *farm;
+  pthread_t thread;
+  size_t index;
+  int cpu; /* pinned to when not negative */
+};
+
+struct fetx_farm {
+  struct fetx_io io; /* compiled once, copied into each instance */
+  struct fetx_farm_instance *instances;
+  size_t instances_size;
+  struct fetx_farm_worker *workers;
+  size_t workers_size;
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t done;
+  size_t pending;  /* jobs submitted and not yet run */
+  size_t starting; /* workers still copying their instances */
+  enum fetx_errs errs;
+  unsigned char quit;
+};
+
+enum fetx_errs fetx_farm_init(struct fetx_farm *const farm,
+                              const struct fetx_netlist nl,
+                              const struct fetx_io_opts opts,
+                              const size_t instances_size,
+                              const size_t workers_size);
+void fetx_farm_submit(struct fetx_farm *const farm, const size_t instance,
+                      struct fetx_farm_job *const job);
+void fetx_farm_wait(struct fetx_farm *const farm);
+struct fetx_io *fetx_farm_instance(struct fetx_farm *const farm,
+                                   const size_t instance);
+void fetx_farm_delete(struct fetx_farm *const farm);
+
+#endif
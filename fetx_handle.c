@@ -0,0 +1,173 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_handle.h"
+
+struct fetx_handle {
+  struct fetx_io io;
+};
+
+/* returns 0 if the runtime could not be allocated */
+
+struct fetx_handle *fetx_handle_new(const struct fetx_netlist *const nl,
+                                    const unsigned int flags) {
+  struct fetx_handle *const handle = fetx_alloc(sizeof(*handle), 1);
+  if (handle == 0) {
+    return 0;
+  }
+  const struct fetx_io_opts opts = {
+      .levelise = ((flags & FETX_HANDLE_LEVELISE) != 0) ? 1 : 0};
+  if (fetx_io_init_opts(&handle->io, *nl, opts) != 0) {
+    fetx_dealloc(handle);
+    return 0;
+  }
+  return handle;
+}
+
+/* builds the runtime from the netlist file at \pathname, returns 0 on
+ * failure with the reason in \errs if it is not 0 */
+
+struct fetx_handle *fetx_handle_open(const char *const pathname,
+                                     const unsigned int flags,
+                                     enum fetx_errs *const errs) {
+  struct fetx_netlist nl;
+  enum fetx_errs e = fetx_netlist_from_file(&nl, pathname);
+  struct fetx_handle *handle = 0;
+  if (e == FETX_ERR_NONE) {
+    handle = fetx_handle_new(&nl, flags);
+    if (handle == 0) {
+      e = FETX_ERR_ALLOC;
+    }
+    fetx_netlist_delete(nl);
+  }
+  if (errs != 0) {
+    *errs = e;
+  }
+  return handle;
+}
+
+void fetx_handle_delete(struct fetx_handle *const handle) {
+  if (handle != 0) {
+    fetx_io_delete(handle->io);
+    fetx_dealloc(handle);
+  }
+}
+
+size_t fetx_handle_inputs_size(const struct fetx_handle *const handle) {
+  return handle->io.inputs_size;
+}
+
+size_t fetx_handle_outputs_size(const struct fetx_handle *const handle) {
+  return handle->io.outputs_size;
+}
+
+void fetx_handle_input_set(struct fetx_handle *const handle,
+                           const size_t input_index,
+                           const enum fetx_node_states state) {
+  fetx_io_input(&handle->io, input_index, state);
+}
+
+enum fetx_node_states
+fetx_handle_output_get(const struct fetx_handle *const handle,
+                       const size_t output_index) {
+  return fetx_node_state_get(*handle->io.outputs[output_index]);
+}
+
+/* sets every input from \inputs and propagates the changes together,
+ * returns the number of inputs that changed */
+
+size_t fetx_handle_inputs_set(struct fetx_handle *const handle,
+                              const unsigned char *const inputs) {
+  struct fetx_io *const io = &handle->io;
+  size_t changed = fetx_io_supplies_list(io);
+  size_t i = 0;
+  while (i < io->inputs_size) {
+    changed +=
+        fetx_io_input_list(io, i, (enum fetx_node_states)inputs[i]);
+    ++i;
+  }
+  if (changed != 0) {
+    fetx_input_nodes_update(&io->fx);
+  }
+  return changed;
+}
+
+void fetx_handle_outputs_get(const struct fetx_handle *const handle,
+                             unsigned char *const outputs) {
+  size_t i = 0;
+  while (i < handle->io.outputs_size) {
+    outputs[i] = (unsigned char)fetx_node_state_get(*handle->io.outputs[i]);
+    ++i;
+  }
+}
+
+unsigned char fetx_handle_resolve(struct fetx_handle *const handle) {
+  return fetx_io_resolve(&handle->io);
+}
+
+/* resolves until the network settles or \time_limit steps have not resolved
+ * it, a limit of 0 never times out. The unresolved steps are added to \time
+ * if it is not 0. Returns 0 once settled, -1 on timeout. */
+
+int fetx_handle_settle(struct fetx_handle *const handle,
+                       const unsigned long int time_limit,
+                       unsigned long int *const time) {
+  unsigned long int steps = 0;
+  unsigned long int now = handle->io.time;
+  int ret = 0;
+  while (fetx_io_resolve(&handle->io) == 0) {
+    steps += handle->io.time - now;
+    now = handle->io.time;
+    if ((time_limit != 0) && (steps > time_limit)) {
+      ret = -1;
+      break;
+    }
+  }
+  if (time != 0) {
+    *time += steps;
+  }
+  return ret;
+}
+
+/* applies a row of inputs, settles and reads the outputs into \outputs if it
+ * is not 0, as fetx_handle_settle */
+
+int fetx_handle_step(struct fetx_handle *const handle,
+                     const unsigned char *const inputs,
+                     unsigned char *const outputs,
+                     const unsigned long int time_limit,
+                     unsigned long int *const time) {
+  fetx_handle_inputs_set(handle, inputs);
+  const int ret = fetx_handle_settle(handle, time_limit, time);
+  if (outputs != 0) {
+    fetx_handle_outputs_get(handle, outputs);
+  }
+  return ret;
+}
+
+size_t fetx_handle_multiple_driven(const struct fetx_handle *const handle) {
+  return fetx_multiple_drive_count(&handle->io.fx);
+}
+
+unsigned long int fetx_handle_time(const struct fetx_handle *const handle) {
+  return handle->io.time;
+}
+
+/* the runtime behind the handle, for the rest of the C API */
+
+struct fetx_io *fetx_handle_io(struct fetx_handle *const handle) {
+  return &handle->io;
+}
@@ -0,0 +1,61 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_HANDLE_H
+#define FETX_HANDLE_H
+
+#include "fetx_io.h"
+
+/* an opaque runtime for use through foreign function interfaces, nothing is
+ * passed by value and states are exchanged through caller provided buffers
+ * of one byte per state, holding enum fetx_node_states values */
+
+struct fetx_handle;
+
+enum fetx_handle_flags { FETX_HANDLE_LEVELISE = 1 };
+
+struct fetx_handle *fetx_handle_new(const struct fetx_netlist *const nl,
+                                    const unsigned int flags);
+struct fetx_handle *fetx_handle_open(const char *const pathname,
+                                     const unsigned int flags,
+                                     enum fetx_errs *const errs);
+void fetx_handle_delete(struct fetx_handle *const handle);
+size_t fetx_handle_inputs_size(const struct fetx_handle *const handle);
+size_t fetx_handle_outputs_size(const struct fetx_handle *const handle);
+void fetx_handle_input_set(struct fetx_handle *const handle,
+                           const size_t input_index,
+                           const enum fetx_node_states state);
+enum fetx_node_states
+fetx_handle_output_get(const struct fetx_handle *const handle,
+                       const size_t output_index);
+size_t fetx_handle_inputs_set(struct fetx_handle *const handle,
+                              const unsigned char *const inputs);
+void fetx_handle_outputs_get(const struct fetx_handle *const handle,
+                             unsigned char *const outputs);
+unsigned char fetx_handle_resolve(struct fetx_handle *const handle);
+int fetx_handle_settle(struct fetx_handle *const handle,
+                       const unsigned long int time_limit,
+                       unsigned long int *const time);
+int fetx_handle_step(struct fetx_handle *const handle,
+                     const unsigned char *const inputs,
+                     unsigned char *const outputs,
+                     const unsigned long int time_limit,
+                     unsigned long int *const time);
+size_t fetx_handle_multiple_driven(const struct fetx_handle *const handle);
+unsigned long int fetx_handle_time(const struct fetx_handle *const handle);
+struct fetx_io *fetx_handle_io(struct fetx_handle *const handle);
+
+#endif
@@ -15,13 +15,243 @@ limitations under the License.
  */
 
 #include "fetx_io.h"
+#include "fetx_trace.h"
+#include "fetx_wheel.h"
 
+#include <pthread.h>
 #include <stdio.h>
+#include <time.h>
+
+/* what is needed to build the inputs that haven't changed yet */
+
+struct fetx_io_lazy {
+  struct fetx_graph graph;
+  unsigned char *built; /* per input */
+  enum fetx_errs errs;  /* set if building an input failed */
+};
+
+static void fetx_io_lazy_delete(struct fetx_io_lazy *const lazy) {
+  fetx_graph_delete(lazy->graph);
+  fetx_dealloc(lazy->built);
+  fetx_dealloc(lazy);
+}
+
+static unsigned long long int fetx_io_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((unsigned long long int)ts.tv_sec * 1000000000ull) + ts.tv_nsec;
+}
+
+static size_t fetx_io_elements_count(const struct fetx_input_node *path) {
+  size_t count = 1;
+  const struct fetx_input_node *output = path->outputs;
+  while (output != 0) {
+    count += fetx_io_elements_count(output);
+    output = output->next_output;
+  }
+  return count;
+}
+
+static int fetx_io_input_build(struct fetx_io *const io,
+                               struct fetx_input_node *const path,
+                               const struct fetx_graph *const graph,
+                               const size_t node_index) {
+  const unsigned long long int start = fetx_io_ns();
+  if (fetx_input_init(path, &io->fx, graph, node_index) != 0) {
+    return -1;
+  }
+  io->stats.build_ns += fetx_io_ns() - start;
+  ++io->stats.inputs_built;
+  io->stats.elements_built += fetx_io_elements_count(path);
+  return 0;
+}
+
+/* raises the peak to the memory held by the runtime, its paths and \graph
+ * along with \extra bytes, the netlist it was built from is not counted */
+
+static void fetx_io_peak_update(struct fetx_io *const io,
+                                const struct fetx_graph *const graph,
+                                const size_t extra) {
+  const size_t roots_size = io->inputs_size + io->supplies_size;
+  const size_t held =
+      fetx_bytes(&io->fx) + fetx_graph_bytes(*graph) + extra +
+      (roots_size * sizeof(*io->inputs)) +
+      (io->supplies_size * sizeof(*io->supply_states)) +
+      ((io->stats.elements_built - io->stats.inputs_built) *
+       sizeof(struct fetx_input_node));
+  if (held > io->stats.peak_bytes_estimate) {
+    io->stats.peak_bytes_estimate = held;
+  }
+}
+
+/* sets up the root of an input whose paths are built later */
+
+static void fetx_io_input_defer(struct fetx_input_node *const path,
+                                struct fetx *const fx,
+                                const size_t node_index) {
+  struct fetx_node *const node = fx->nodes + node_index;
+  node->is_input = 1;
+  path->node = node;
+  path->state = FETX_UNDRIVEN;
+  path->link.input = 0;
+  path->outputs = 0;
+  path->next_output = 0;
+  path->next_listed = 0;
+  path->is_listed = 0;
+}
+
+/* builds the paths of an input before its first change. Until then it is
+ * undriven so its paths could only carry FETX_UNDRIVEN, which nodes don't
+ * count, and building them later gives the same states. If they can't be
+ * built the input is left undriven and the io is failed. */
+
+static int fetx_io_input_ensure(struct fetx_io *const io,
+                                const size_t input_index) {
+  struct fetx_io_lazy *const lazy = io->lazy;
+  if ((lazy == 0) || (lazy->built[input_index] != 0)) {
+    return 0;
+  }
+  if (lazy->errs != FETX_ERR_NONE) {
+    return -1;
+  }
+  struct fetx_input_node *const path = io->inputs + input_index;
+  if (fetx_io_input_build(io, path, &lazy->graph, path->node - io->fx.nodes) !=
+      0) {
+    lazy->errs = FETX_ERR_ALLOC;
+    return -1;
+  }
+  lazy->built[input_index] = 1;
+  fetx_io_peak_update(io, &lazy->graph, 0);
+  return 0;
+}
+
+/* shared by the threads building the input paths, each takes the next root
+ * to build until none are left */
+
+struct fetx_io_builder {
+  struct fetx_io *io;
+  const struct fetx_graph *graph;
+  const unsigned char *skip; /* roots left to build lazily, or 0 */
+  size_t roots_size;
+  pthread_mutex_t lock;
+  size_t next;
+  int failed;
+};
+
+static void *fetx_io_builder_run(void *const arg) {
+  struct fetx_io_builder *const builder = arg;
+  struct fetx_io *const io = builder->io;
+  /* per thread as the node flags are shared */
+  unsigned char *const on_path =
+      fetx_calloc(builder->graph->nodes_size, sizeof(*on_path));
+  pthread_mutex_lock(&builder->lock);
+  if (on_path == 0) {
+    builder->failed = 1;
+  }
+  while ((builder->failed == 0) && (builder->next < builder->roots_size)) {
+    const size_t i = builder->next;
+    ++builder->next;
+    if ((builder->skip != 0) && (builder->skip[i] != 0)) {
+      continue;
+    }
+    pthread_mutex_unlock(&builder->lock);
+    struct fetx_input_node *const path = io->inputs + i;
+    const int ret = fetx_input_build(path, &io->fx, builder->graph,
+                                     path->node - io->fx.nodes, on_path);
+    pthread_mutex_lock(&builder->lock);
+    if (ret != 0) {
+      builder->failed = 1;
+    }
+  }
+  pthread_mutex_unlock(&builder->lock);
+  fetx_dealloc(on_path);
+  return 0;
+}
+
+/* builds the paths of the roots in \io->inputs, which must be set up as by
+ * fetx_io_input_defer, on \workers_size threads and then links them into the
+ * runtime in order on the calling thread. Roots with \skip set are left. */
+
+static int fetx_io_roots_build(struct fetx_io *const io,
+                               const struct fetx_graph *const graph,
+                               const size_t roots_size,
+                               const unsigned char *const skip,
+                               const size_t workers_size) {
+  const unsigned long long int start = fetx_io_ns();
+  pthread_t *const threads = fetx_alloc(sizeof(*threads), workers_size);
+  if (threads == 0) {
+    return -1;
+  }
+  struct fetx_io_builder builder = {.io = io,
+                                    .graph = graph,
+                                    .skip = skip,
+                                    .roots_size = roots_size,
+                                    .next = 0,
+                                    .failed = 0};
+  pthread_mutex_init(&builder.lock, 0);
+  size_t started = 0;
+  while (started < workers_size) {
+    if (pthread_create(threads + started, 0, fetx_io_builder_run, &builder) !=
+        0) {
+      /* the rest of the roots are taken by the threads that did start */
+      break;
+    }
+    ++started;
+  }
+  if (started == 0) {
+    fetx_io_builder_run(&builder);
+  }
+  size_t i = 0;
+  while (i < started) {
+    pthread_join(threads[i], 0);
+    ++i;
+  }
+  pthread_mutex_destroy(&builder.lock);
+  fetx_dealloc(threads);
+  if (builder.failed != 0) {
+    return -1;
+  }
+
+  /* in the order serial init builds them so the path counts and FET links
+   * come out the same */
+  i = 0;
+  while (i < roots_size) {
+    if ((skip == 0) || (skip[i] == 0)) {
+      if (fetx_input_link(&io->fx, io->inputs + i) != 0) {
+        return -1;
+      }
+      ++io->stats.inputs_built;
+      io->stats.elements_built += fetx_io_elements_count(io->inputs + i);
+    }
+    ++i;
+  }
+  io->stats.build_ns += fetx_io_ns() - start;
+  return 0;
+}
+
+/* takes \graph */
+
+static struct fetx_io_lazy *fetx_io_lazy_new(const struct fetx_graph graph,
+                                             const size_t inputs_size) {
+  struct fetx_io_lazy *const lazy = fetx_alloc(sizeof(*lazy), 1);
+  if (lazy == 0) {
+    fetx_graph_delete(graph);
+    return 0;
+  }
+  lazy->graph = graph;
+  lazy->errs = FETX_ERR_NONE;
+  lazy->built = fetx_calloc(inputs_size, sizeof(*lazy->built));
+  if ((lazy->built == 0) && (inputs_size != 0)) {
+    fetx_io_lazy_delete(lazy);
+    return 0;
+  }
+  return lazy;
+}
 
 void fetx_io_delete(struct fetx_io io) {
   if (io.inputs != 0) {
     size_t i = 0;
-    while (i < io.inputs_size) {
+    while (i < (io.inputs_size + io.supplies_size)) {
       fetx_input_delete(io.inputs[i]);
       ++i;
     }
@@ -32,45 +262,169 @@ void fetx_io_delete(struct fetx_io io) {
     fetx_dealloc(io.outputs);
     io.outputs = 0;
   }
+  if (io.lazy != 0) {
+    fetx_io_lazy_delete(io.lazy);
+  }
+  fetx_dealloc(io.supply_states);
   fetx_delete(io.fx);
 }
 
 int fetx_io_init(struct fetx_io *const io, const struct fetx_netlist nl) {
+  const struct fetx_io_opts opts = {.levelise = 0};
+  return fetx_io_init_opts(io, nl, opts);
+}
+
+int fetx_io_init_opts(struct fetx_io *const io, const struct fetx_netlist nl,
+                      const struct fetx_io_opts opts) {
+  if (opts.fold != 0) {
+    struct fetx_netlist folded;
+    if (fetx_netlist_fold(&folded, 0, nl) != FETX_ERR_NONE) {
+      return -1;
+    }
+    struct fetx_io_opts unfolded = opts;
+    unfolded.fold = 0;
+    const int ret = fetx_io_init_opts(io, folded, unfolded);
+    fetx_netlist_delete(folded);
+    if (ret == 0) {
+      io->stats.folded = 1;
+    }
+    return ret;
+  }
   io->inputs = 0;
   io->outputs = 0;
-  /* generate intermediate */
-  struct fetx_inter fxi;
-  if (fetx_inter_init_fns(&fxi, nl.fl, nl.nodes_size) != 0) {
+  io->inputs_size = 0;
+  io->supplies_size = 0;
+  io->supply_states = 0;
+  io->trace = 0;
+  io->time = 0;
+  io->lazy = 0;
+  io->stats = (struct fetx_io_stats){.inputs_built = 0};
+  const int lazy =
+      (opts.lazy != 0) && (opts.levelise == 0) && (opts.memo == 0);
+  /* the runtime and the graph the paths are built from are both made
+   * straight from the FET list */
+  if (fetx_init(&io->fx, nl.fl, nl.nodes_size) != 0) {
     return -1;
   }
-  /* generate runtime data */
-  if (fetx_init(&io->fx, fxi) != 0) {
-    fetx_inter_delete(fxi);
+  struct fetx_graph graph;
+  if (fetx_graph_init(&graph, nl.fl, nl.nodes_size) != 0) {
+    fetx_delete(io->fx);
     return -1;
   }
 
-  /* fill inputs arr in io struct */
-  io->inputs = fetx_alloc(sizeof(*io->inputs), nl.inputs_size);
-  if (io->inputs == 0) {
-    fetx_inter_delete(fxi);
-    fetx_delete(io->fx);
+  /* fill inputs arr in io struct, the supplies follow the inputs */
+  size_t roots_size = nl.inputs_size + nl.supplies_size;
+  io->inputs = fetx_alloc(sizeof(*io->inputs), roots_size);
+  io->supply_states =
+      fetx_alloc(sizeof(*io->supply_states), nl.supplies_size);
+  if ((io->inputs == 0) ||
+      ((io->supply_states == 0) && (nl.supplies_size != 0))) {
+    fetx_graph_delete(graph);
+    fetx_io_delete(*io);
     return -1;
   }
 
+  /* every path must know where the supplies are before it is built */
   size_t i = 0;
-  while (i < nl.inputs_size) {
-    if (fetx_input_init(io->inputs + i, &io->fx, fxi.nodes[nl.inputs[i]]) !=
-        0) {
-      fetx_inter_delete(fxi);
-      io->inputs_size = i;
+  while (i < nl.supplies_size) {
+    io->fx.nodes[nl.supplies[i].node].is_supply = 1;
+    io->supply_states[i] = nl.supplies[i].state;
+    ++i;
+  }
+
+  if (opts.init_workers > 1) {
+    /* every root is set up first so any can be deleted on failure */
+    i = 0;
+    while (i < roots_size) {
+      fetx_io_input_defer(io->inputs + i, &io->fx,
+                          (i < nl.inputs_size)
+                              ? nl.inputs[i]
+                              : nl.supplies[i - nl.inputs_size].node);
+      ++i;
+    }
+    io->inputs_size = nl.inputs_size;
+    io->supplies_size = nl.supplies_size;
+    /* only the supplies are built now when lazy */
+    unsigned char *skip = 0;
+    if (lazy != 0) {
+      skip = fetx_calloc(roots_size, sizeof(*skip));
+      if (skip == 0) {
+        fetx_graph_delete(graph);
+        fetx_io_delete(*io);
+        return -1;
+      }
+      i = 0;
+      while (i < nl.inputs_size) {
+        skip[i] = 1;
+        ++i;
+      }
+    }
+    const int ret =
+        fetx_io_roots_build(io, &graph, roots_size, skip, opts.init_workers);
+    fetx_dealloc(skip);
+    if (ret != 0) {
+      fetx_graph_delete(graph);
       fetx_io_delete(*io);
       return -1;
     }
-    ++i;
+  } else {
+    i = 0;
+    while (i < nl.inputs_size) {
+      if (lazy != 0) {
+        fetx_io_input_defer(io->inputs + i, &io->fx, nl.inputs[i]);
+      } else if (fetx_io_input_build(io, io->inputs + i, &graph,
+                                     nl.inputs[i]) != 0) {
+        fetx_graph_delete(graph);
+        io->inputs_size = i;
+        fetx_io_delete(*io);
+        return -1;
+      }
+      ++i;
+    }
+    io->inputs_size = i;
+
+    /* supplies are driven from the start so are always built */
+    i = 0;
+    while (i < nl.supplies_size) {
+      if (fetx_io_input_build(io, io->inputs + io->inputs_size + i, &graph,
+                              nl.supplies[i].node) != 0) {
+        fetx_graph_delete(graph);
+        io->supplies_size = i;
+        fetx_io_delete(*io);
+        return -1;
+      }
+      ++i;
+    }
+    io->supplies_size = i;
   }
-  io->inputs_size = i;
 
-  fetx_inter_delete(fxi);
+  /* the graph is freed before levelising, so it's held longest here */
+  fetx_io_peak_update(io, &graph,
+                      (opts.init_workers > 1)
+                          ? (opts.init_workers * graph.nodes_size)
+                          : 0);
+
+  /* the graph is kept for building the inputs */
+  if (lazy != 0) {
+    io->lazy = fetx_io_lazy_new(graph, io->inputs_size);
+    if (io->lazy == 0) {
+      fetx_io_delete(*io);
+      return -1;
+    }
+  } else {
+    fetx_graph_delete(graph);
+  }
+
+  /* circuits with feedback stay event driven, as do those with delays */
+  if ((opts.levelise != 0) && (io->fx.wheel == 0) &&
+      (fetx_levelise(&io->fx, io->inputs, roots_size) < 0)) {
+    fetx_io_delete(*io);
+    return -1;
+  }
+  if ((opts.memo != 0) && (fetx_io_memo_init(io) != 0)) {
+    fetx_io_delete(*io);
+    return -1;
+  }
 
   /* fill outputs arr in io struct */
   io->outputs = fetx_alloc(sizeof(*io->outputs), nl.outputs_size);
@@ -88,8 +442,301 @@ int fetx_io_init(struct fetx_io *const io, const struct fetx_netlist nl) {
   return 0;
 }
 
+/* counts the path elements fetx_io_init_opts would build for \nl, without
+ * building them, and projects the memory it would take. Counting
+ * stops once \elements_cap elements are found, or never if 0, so a netlist
+ * with too many paths is found quickly. If \counts is not 0 it is filled
+ * with the elements of each input then each supply, those not reached
+ * before the cap are 0. Options are not taken into account. */
+
+enum fetx_errs fetx_io_estimate(struct fetx_io_estimate *const est,
+                                size_t *const counts,
+                                const struct fetx_netlist nl,
+                                const size_t elements_cap) {
+  struct fetx fx;
+  if (fetx_init(&fx, nl.fl, nl.nodes_size) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+  struct fetx_graph graph;
+  if (fetx_graph_init(&graph, nl.fl, nl.nodes_size) != 0) {
+    fetx_delete(fx);
+    return FETX_ERR_ALLOC;
+  }
+  unsigned char *const on_path = fetx_calloc(nl.nodes_size, sizeof(*on_path));
+  struct fetx_graph_edge *const path =
+      fetx_alloc(sizeof(*path), nl.nodes_size);
+  if ((on_path == 0) || (path == 0)) {
+    fetx_dealloc(on_path);
+    fetx_dealloc(path);
+    fetx_graph_delete(graph);
+    fetx_delete(fx);
+    return FETX_ERR_ALLOC;
+  }
+  size_t i = 0;
+  while (i < nl.supplies_size) {
+    fx.nodes[nl.supplies[i].node].is_supply = 1;
+    ++i;
+  }
+
+  const size_t cap = (elements_cap == 0) ? (size_t)-1 : elements_cap;
+  const size_t roots_size = nl.inputs_size + nl.supplies_size;
+  size_t elements = 0;
+  i = 0;
+  while (i < roots_size) {
+    size_t count = 0;
+    if (elements < cap) {
+      count = fetx_input_count(
+          &fx, &graph,
+          (i < nl.inputs_size) ? nl.inputs[i]
+                               : nl.supplies[i - nl.inputs_size].node,
+          cap - elements, on_path, path);
+    }
+    if (counts != 0) {
+      counts[i] = count;
+    }
+    elements += count;
+    ++i;
+  }
+
+  est->elements = elements;
+  est->capped = (elements >= cap);
+  /* as fetx_io_peak_update would find once every path is built */
+  est->peak_bytes = fetx_bytes(&fx) + fetx_graph_bytes(graph) +
+                    (roots_size * sizeof(struct fetx_input_node)) +
+                    (nl.supplies_size * sizeof(enum fetx_node_states)) +
+                    ((elements - ((elements < roots_size) ? elements
+                                                          : roots_size)) *
+                     sizeof(struct fetx_input_node));
+
+  fetx_dealloc(on_path);
+  fetx_dealloc(path);
+  fetx_graph_delete(graph);
+  fetx_delete(fx);
+  return FETX_ERR_NONE;
+}
+
+/* the number of path elements that fit in \budget bytes, counting stops
+ * at one more so that a runtime over the budget is found without counting
+ * all of it */
+
+static enum fetx_errs fetx_io_fits(int *const fits,
+                                   const struct fetx_netlist nl,
+                                   const size_t budget) {
+  struct fetx_io_estimate est;
+  const enum fetx_errs errs = fetx_io_estimate(
+      &est, 0, nl, (budget / sizeof(struct fetx_input_node)) + 1);
+  *fits = (errs == FETX_ERR_NONE) && (est.capped == 0) &&
+          (est.peak_bytes <= budget);
+  return errs;
+}
+
+/* as fetx_io_init_opts if the runtime is estimated to fit in \budget bytes
+ * of stats.peak_bytes_estimate. If it doesn't and \nl has supplies it is
+ * folded, which builds fewer paths, and stats.folded is set. The times and
+ * node indices are then those of the folded netlist. If that doesn't fit
+ * either no paths are built. */
+
+enum fetx_errs fetx_io_init_budget(struct fetx_io *const io,
+                                   const struct fetx_netlist nl,
+                                   const struct fetx_io_opts opts,
+                                   const size_t budget) {
+  int fits;
+  enum fetx_errs errs = fetx_io_fits(&fits, nl, budget);
+  if (errs != FETX_ERR_NONE) {
+    return errs;
+  }
+  if (fits != 0) {
+    return (fetx_io_init_opts(io, nl, opts) != 0) ? FETX_ERR_ALLOC
+                                                  : FETX_ERR_NONE;
+  }
+  if ((opts.fold != 0) || (nl.supplies_size == 0)) {
+    return FETX_ERR_BUDGET;
+  }
+
+  struct fetx_netlist folded;
+  errs = fetx_netlist_fold(&folded, 0, nl);
+  if (errs != FETX_ERR_NONE) {
+    return errs;
+  }
+  errs = fetx_io_fits(&fits, folded, budget);
+  if ((errs == FETX_ERR_NONE) && (fits == 0)) {
+    errs = FETX_ERR_BUDGET;
+  }
+  if (errs == FETX_ERR_NONE) {
+    if (fetx_io_init_opts(io, folded, opts) != 0) {
+      errs = FETX_ERR_ALLOC;
+    } else {
+      io->stats.folded = 1;
+    }
+  }
+  fetx_netlist_delete(folded);
+  return errs;
+}
+
+/* copies \src, which must not have updates pending, into \io. The copy has
+ * the same states, and no trace. */
+
+int fetx_io_clone(struct fetx_io *const io, const struct fetx_io *const src) {
+  if ((src->fx.fets_update != 0) || (src->fx.input_nodes_update != 0) ||
+      (src->fx.level < src->fx.levels_size) ||
+      ((src->fx.wheel != 0) && (src->fx.wheel->size != 0))) {
+    return -1;
+  }
+  io->inputs = 0;
+  io->outputs = 0;
+  io->inputs_size = 0;
+  io->outputs_size = 0;
+  io->supplies_size = 0;
+  io->supply_states = 0;
+  io->trace = 0;
+  io->time = src->time;
+  io->lazy = 0;
+  io->stats = src->stats;
+  if (fetx_clone(&io->fx, &src->fx) != 0) {
+    return -1;
+  }
+  if (src->lazy != 0) {
+    struct fetx_graph graph;
+    if (fetx_graph_clone(&graph, src->lazy->graph) != 0) {
+      fetx_delete(io->fx);
+      return -1;
+    }
+    io->lazy = fetx_io_lazy_new(graph, src->inputs_size);
+    if (io->lazy == 0) {
+      fetx_delete(io->fx);
+      return -1;
+    }
+    size_t i = 0;
+    while (i < src->inputs_size) {
+      io->lazy->built[i] = src->lazy->built[i];
+      ++i;
+    }
+    io->lazy->errs = src->lazy->errs;
+  }
+  io->inputs = fetx_alloc(sizeof(*io->inputs),
+                          src->inputs_size + src->supplies_size);
+  io->outputs = fetx_alloc(sizeof(*io->outputs), src->outputs_size);
+  io->supply_states =
+      fetx_alloc(sizeof(*io->supply_states), src->supplies_size);
+  if ((io->inputs == 0) || (io->outputs == 0) ||
+      ((io->supply_states == 0) && (src->supplies_size != 0))) {
+    fetx_io_delete(*io);
+    return -1;
+  }
+  size_t i = 0;
+  while (i < src->inputs_size) {
+    const int ret =
+        fetx_input_clone(io->inputs + i, &io->fx, src->inputs + i, &src->fx);
+    io->inputs_size = i + 1;
+    if (ret != 0) {
+      fetx_io_delete(*io);
+      return -1;
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < src->supplies_size) {
+    const size_t root = src->inputs_size + i;
+    const int ret = fetx_input_clone(io->inputs + root, &io->fx,
+                                     src->inputs + root, &src->fx);
+    io->supply_states[i] = src->supply_states[i];
+    io->supplies_size = i + 1;
+    if (ret != 0) {
+      fetx_io_delete(*io);
+      return -1;
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < src->outputs_size) {
+    io->outputs[i] = io->fx.nodes + (src->outputs[i] - src->fx.nodes);
+    ++i;
+  }
+  io->outputs_size = i;
+  if ((src->fx.cells != 0) && (fetx_io_memo_init(io) != 0)) {
+    fetx_io_delete(*io);
+    return -1;
+  }
+  return 0;
+}
+
+/* memoises the cells of a runtime built with every path, a copy starts with
+ * empty tables */
+
+int fetx_io_memo_init(struct fetx_io *const io) {
+  if ((io->lazy != 0) || (io->fx.cells != 0)) {
+    return 0;
+  }
+  return fetx_cells_init(&io->fx, io->inputs,
+                         io->inputs_size + io->supplies_size);
+}
+
+void fetx_io_memo_stats(struct fetx_io_memo *const memo,
+                        const struct fetx_io *const io) {
+  *memo = (struct fetx_io_memo){.cells = 0};
+  const struct fetx_cells *const cells = io->fx.cells;
+  if (cells == 0) {
+    return;
+  }
+  memo->cells = cells->size;
+  size_t i = 0;
+  while (i < cells->size) {
+    memo->fets += cells->cells[i].fets_size;
+    ++i;
+  }
+  memo->hits = cells->hits;
+  memo->misses = cells->misses;
+  memo->bytes = cells->bytes;
+}
+
+/* returns FETX_ERR_ALLOC if the paths of an input could not be built, the
+ * input is then left undriven */
+
+enum fetx_errs fetx_io_errs(const struct fetx_io *const io) {
+  return (io->lazy != 0) ? io->lazy->errs : FETX_ERR_NONE;
+}
+
+/* lists any supply not at its level, which is all of them before the first
+ * change of the inputs, to be propagated with the inputs. Driving them then
+ * rather than when the runtime is built leaves nothing pending so the
+ * runtime can be copied. Returns the number listed. */
+
+size_t fetx_io_supplies_list(struct fetx_io *const io) {
+  size_t listed = 0;
+  size_t i = 0;
+  while (i < io->supplies_size) {
+    struct fetx_input_node *const root = io->inputs + io->inputs_size + i;
+    if (root->state != io->supply_states[i]) {
+      fetx_input_state_list(&io->fx, root, io->supply_states[i]);
+      ++listed;
+    }
+    ++i;
+  }
+  return listed;
+}
+
+/* lists a change of an input to be propagated with fetx_input_nodes_update,
+ * returns 1 if it was listed */
+
+size_t fetx_io_input_list(struct fetx_io *const io, const size_t input_index,
+                          const enum fetx_node_states state) {
+  if ((io->inputs[input_index].state == state) ||
+      (fetx_io_input_ensure(io, input_index) != 0)) {
+    return 0;
+  }
+  fetx_input_state_list(&io->fx, io->inputs + input_index, state);
+  return 1;
+}
+
 void fetx_io_input(struct fetx_io *const io, const size_t input_index,
                    const enum fetx_node_states state) {
+  if (fetx_io_supplies_list(io) != 0) {
+    fetx_input_nodes_update(&io->fx);
+  }
+  if ((io->inputs[input_index].state != state) &&
+      (fetx_io_input_ensure(io, input_index) != 0)) {
+    return;
+  }
   fetx_input_state_set(&io->fx, io->inputs + input_index, state);
 }
 
@@ -100,11 +747,24 @@ enum fetx_node_states fetx_io_output(const struct fetx_io io,
 
 void fetx_io_inputs(struct fetx_io *const io,
                     const enum fetx_node_states *const inputs) {
+  fetx_io_inputs_apply(io, inputs);
+}
+
+/* only the inputs that differ from their current state are set and their
+ * paths are propagated together once all of them have been set */
+
+size_t fetx_io_inputs_apply(struct fetx_io *const io,
+                            const enum fetx_node_states *const inputs) {
+  size_t changed = fetx_io_supplies_list(io);
   size_t i = 0;
   while (i < io->inputs_size) {
-    fetx_io_input(io, i, inputs[i]);
+    changed += fetx_io_input_list(io, i, inputs[i]);
     ++i;
   }
+  if (changed != 0) {
+    fetx_input_nodes_update(&io->fx);
+  }
+  return changed;
 }
 
 void fetx_io_outputs(enum fetx_node_states *const outputs,
@@ -117,5 +777,14 @@ void fetx_io_outputs(enum fetx_node_states *const outputs,
 }
 
 unsigned char fetx_io_resolve(struct fetx_io *const io) {
-  return fetx_resolve(&io->fx);
+  const unsigned long long int before = io->fx.time;
+  const unsigned char resolved = fetx_resolve(&io->fx);
+  /* the changes of a step are recorded a time unit before it, the time the
+   * step was taken from when there are no delays */
+  io->time += (io->fx.time - before) - 1;
+  if (io->trace != 0) {
+    fetx_trace_sample(io->trace, io);
+  }
+  ++io->time;
+  return resolved;
 }
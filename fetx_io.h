@@ -22,22 +22,103 @@ limitations under the License.
 /* fetx_io is a wrapper around fetx that represents a modular circuit
  * with abstracted inputs and outputs. */
 
+struct fetx_trace;
+struct fetx_io_lazy;
+
+/* the cost of building the input paths, which is charged to the first change
+ * of each input when they are built lazily */
+
+struct fetx_io_stats {
+  size_t inputs_built;
+  size_t elements_built; /* path elements in the built inputs */
+  unsigned long long int build_ns;
+  /* built from the netlist folded, see fetx_netlist_fold */
+  unsigned int folded : 1;
+  /* most held at once by the runtime and its build, summed from the sizes
+   * allocated rather than measured */
+  size_t peak_bytes_estimate;
+};
+
 struct fetx_io {
   struct fetx fx;
-  struct fetx_input_node *inputs;
+  struct fetx_input_node *inputs; /* followed by the supplies */
   struct fetx_node **outputs;
   size_t inputs_size;
   size_t outputs_size;
+  size_t supplies_size;
+  enum fetx_node_states *supply_states;
+  struct fetx_trace *trace; /* sampled after each resolve step when not 0 */
+  unsigned long int time;   /* resolve steps taken, or delay units */
+  struct fetx_io_lazy *lazy; /* inputs not built yet when not 0 */
+  struct fetx_io_stats stats;
+};
+
+/* options for building the runtime, zero initialise for the defaults */
+
+struct fetx_io_opts {
+  /* resolve in dependency order when the circuit has no feedback */
+  unsigned int levelise : 1;
+  /* build the paths of each input the first time it changes, ignored when
+   * levelised as that needs every path */
+  unsigned int lazy : 1;
+  /* build from the netlist with its supplies folded in, see
+   * fetx_netlist_fold */
+  unsigned int fold : 1;
+  /* look up the node states of the small cells between the supplies from
+   * the states of their FETs once seen, ignored with delays and lazy
+   * building is off as it needs every path */
+  unsigned int memo : 1;
+  /* threads to build the paths of the inputs on, 0 or 1 builds them on the
+   * calling thread. The runtime is the same either way. */
+  size_t init_workers;
+};
+
+/* what building a runtime would cost, from counting its paths */
+
+struct fetx_io_estimate {
+  size_t elements; /* path elements, a lower bound if capped */
+  unsigned int capped : 1; /* counting stopped at the cap */
+  size_t peak_bytes; /* projected stats.peak_bytes_estimate */
+};
+
+/* how often the memoised cells were looked up rather than walked */
+
+struct fetx_io_memo {
+  size_t cells;
+  size_t fets; /* in the cells */
+  unsigned long long int hits;
+  unsigned long long int misses;
+  size_t bytes; /* held by the tables */
 };
 
 void fetx_io_delete(struct fetx_io io);
 int fetx_io_init(struct fetx_io *const io, const struct fetx_netlist nl);
+int fetx_io_init_opts(struct fetx_io *const io, const struct fetx_netlist nl,
+                      const struct fetx_io_opts opts);
+enum fetx_errs fetx_io_estimate(struct fetx_io_estimate *const est,
+                                size_t *const counts,
+                                const struct fetx_netlist nl,
+                                const size_t elements_cap);
+enum fetx_errs fetx_io_init_budget(struct fetx_io *const io,
+                                   const struct fetx_netlist nl,
+                                   const struct fetx_io_opts opts,
+                                   const size_t budget);
+int fetx_io_clone(struct fetx_io *const io, const struct fetx_io *const src);
+int fetx_io_memo_init(struct fetx_io *const io);
+void fetx_io_memo_stats(struct fetx_io_memo *const memo,
+                        const struct fetx_io *const io);
+enum fetx_errs fetx_io_errs(const struct fetx_io *const io);
+size_t fetx_io_supplies_list(struct fetx_io *const io);
+size_t fetx_io_input_list(struct fetx_io *const io, const size_t input_index,
+                          const enum fetx_node_states state);
 void fetx_io_input(struct fetx_io *const io, const size_t input_index,
                    const enum fetx_node_states state);
 enum fetx_node_states fetx_io_output(const struct fetx_io io,
                                      const size_t output_index);
 void fetx_io_inputs(struct fetx_io *const io,
                     const enum fetx_node_states *const inputs);
+size_t fetx_io_inputs_apply(struct fetx_io *const io,
+                            const enum fetx_node_states *const inputs);
 void fetx_io_outputs(enum fetx_node_states *const outputs,
                      const struct fetx_io io);
 unsigned char fetx_io_resolve(struct fetx_io *const io);
@@ -16,6 +16,7 @@ limitations under the License.
 
 #include "fetx_netlist.h"
 
+#include <limits.h>
 #include <stdio.h>
 
 void fetx_netlist_delete(struct fetx_netlist nl) {
@@ -26,6 +27,9 @@ void fetx_netlist_delete(struct fetx_netlist nl) {
   if (nl.outputs != 0) {
     fetx_dealloc(nl.outputs);
   }
+  if (nl.supplies != 0) {
+    fetx_dealloc(nl.supplies);
+  }
 }
 
 enum fetx_errs fetx_netlist_new(struct fetx_netlist *const nl) {
@@ -37,6 +41,10 @@ enum fetx_errs fetx_netlist_new(struct fetx_netlist *const nl) {
   if (nl->outputs == 0) {
     return FETX_ERR_ALLOC;
   }
+  nl->supplies = fetx_alloc(sizeof(*nl->supplies), nl->supplies_size);
+  if ((nl->supplies == 0) && (nl->supplies_size != 0)) {
+    return FETX_ERR_ALLOC;
+  }
   return (fetx_fetlist_new(&nl->fl) != 0) ? FETX_ERR_ALLOC : FETX_ERR_NONE;
 }
 
@@ -56,15 +64,637 @@ void fetx_netlist_assign_output(struct fetx_netlist *const nl,
   nl->outputs[index] = node_index;
 }
 
+void fetx_netlist_assign_supply(struct fetx_netlist *const nl,
+                                const struct fetx_netlist_supply supply,
+                                const size_t index) {
+  nl->supplies[index] = supply;
+}
+
 void fetx_netlist_update_nodes_size(struct fetx_netlist *const nl) {
   nl->nodes_size = fetx_fetlist_find_last_node(nl->fl) + 1;
 }
 
+void fetx_netlist_map_delete(struct fetx_netlist_map map) {
+  if (map.nodes != 0) {
+    fetx_dealloc(map.nodes);
+  }
+  if (map.fets != 0) {
+    fetx_dealloc(map.fets);
+  }
+}
+
+/* allocates \out with the sizes of \nl, on failure \out is left empty */
+
+static enum fetx_errs fetx_netlist_new_as(struct fetx_netlist *const out,
+                                         const struct fetx_netlist nl) {
+  out->fl.fets = 0;
+  out->inputs = 0;
+  out->outputs = 0;
+  out->supplies = 0;
+  out->fl.size = nl.fl.size;
+  out->inputs_size = nl.inputs_size;
+  out->outputs_size = nl.outputs_size;
+  out->supplies_size = nl.supplies_size;
+  out->nodes_size = nl.nodes_size;
+  enum fetx_errs errs = fetx_netlist_new(out);
+  if (errs != FETX_ERR_NONE) {
+    fetx_netlist_delete(*out);
+    out->fl.fets = 0;
+    out->inputs = 0;
+    out->outputs = 0;
+    out->supplies = 0;
+  }
+  return errs;
+}
+
+/* node to FET adjacency in compressed rows, every terminal of every FET is
+ * listed so a FET whose gate is tied to its channel appears twice */
+
+struct fetx_netlist_adj {
+  size_t *offsets; /* nodes_size + 1 entries */
+  size_t *fets;
+};
+
+static void fetx_netlist_adj_delete(struct fetx_netlist_adj adj) {
+  fetx_dealloc(adj.offsets);
+  fetx_dealloc(adj.fets);
+}
+
+static int fetx_netlist_adj_init(struct fetx_netlist_adj *const adj,
+                                 const struct fetx_netlist nl) {
+  size_t n;
+  if (fetx_check_multiply(&n, nl.fl.size, 3) != 0) {
+    return -1;
+  }
+  adj->offsets = fetx_calloc(nl.nodes_size + 1, sizeof(*adj->offsets));
+  if (adj->offsets == 0) {
+    return -1;
+  }
+  adj->fets = fetx_alloc(sizeof(*adj->fets), n);
+  if (adj->fets == 0) {
+    fetx_dealloc(adj->offsets);
+    return -1;
+  }
+
+  size_t f = 0;
+  while (f < nl.fl.size) {
+    unsigned char c = 0;
+    while (c < 3) {
+      ++adj->offsets[nl.fl.fets[f].connections[c] + 1];
+      ++c;
+    }
+    ++f;
+  }
+  n = 0;
+  while (n < nl.nodes_size) {
+    adj->offsets[n + 1] += adj->offsets[n];
+    ++n;
+  }
+  /* fill using the row starts as cursors then shift them back */
+  f = 0;
+  while (f < nl.fl.size) {
+    unsigned char c = 0;
+    while (c < 3) {
+      adj->fets[adj->offsets[nl.fl.fets[f].connections[c]]++] = f;
+      ++c;
+    }
+    ++f;
+  }
+  n = nl.nodes_size;
+  while (n > 0) {
+    adj->offsets[n] = adj->offsets[n - 1];
+    --n;
+  }
+  adj->offsets[0] = 0;
+  return 0;
+}
+
+/* copies the supplies of \nl into \out with their nodes renumbered */
+
+static void fetx_netlist_supplies_map(struct fetx_netlist *const out,
+                                      const struct fetx_netlist nl,
+                                      const size_t *const node_new) {
+  size_t i = 0;
+  while (i < nl.supplies_size) {
+    struct fetx_netlist_supply supply = nl.supplies[i];
+    supply.node = node_new[supply.node];
+    fetx_netlist_assign_supply(out, supply, i);
+    ++i;
+  }
+}
+
+/* state shared by the reordering helpers, \map->nodes doubles as the
+ * breadth first queue */
+
+struct fetx_netlist_reorder_state {
+  struct fetx_netlist_map *map;
+  size_t *node_new;
+  size_t *fet_new;
+  size_t nodes_tail;
+  size_t fets_tail;
+};
+
+static void fetx_netlist_reorder_node(struct fetx_netlist_reorder_state *s,
+                                      const size_t node) {
+  if (s->node_new[node] == s->map->nodes_size) {
+    s->node_new[node] = s->nodes_tail;
+    s->map->nodes[s->nodes_tail] = node;
+    ++s->nodes_tail;
+  }
+}
+
+static void fetx_netlist_reorder_fet(struct fetx_netlist_reorder_state *s,
+                                     const size_t fet) {
+  if (s->fet_new[fet] == s->map->fets_size) {
+    s->fet_new[fet] = s->fets_tail;
+    s->map->fets[s->fets_tail] = fet;
+    ++s->fets_tail;
+  }
+}
+
+/* renumbers the nodes breadth first from the inputs and numbers the FETs in
+ * the order their nodes are reached, so that devices that interact in the
+ * resolve loop are close together in memory. Inputs are numbered first but
+ * not expanded through, otherwise the supply rails would make nearly every
+ * device adjacent to every other. \map may be 0, otherwise it receives the
+ * original index of each node and FET in \out */
+
+enum fetx_errs fetx_netlist_reorder(struct fetx_netlist *const out,
+                                    struct fetx_netlist_map *const map,
+                                    const struct fetx_netlist nl) {
+  struct fetx_netlist_map tmp_map = {.nodes_size = nl.nodes_size,
+                                     .fets_size = nl.fl.size};
+  struct fetx_netlist_reorder_state s = {.map = &tmp_map};
+
+  struct fetx_netlist_adj adj;
+  if (fetx_netlist_adj_init(&adj, nl) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+  tmp_map.nodes = fetx_alloc(sizeof(*tmp_map.nodes), nl.nodes_size);
+  tmp_map.fets = fetx_alloc(sizeof(*tmp_map.fets), nl.fl.size);
+  s.node_new = fetx_alloc(sizeof(*s.node_new), nl.nodes_size);
+  s.fet_new = fetx_alloc(sizeof(*s.fet_new), nl.fl.size);
+  if ((tmp_map.nodes == 0) || (tmp_map.fets == 0) || (s.node_new == 0) ||
+      (s.fet_new == 0)) {
+    fetx_netlist_adj_delete(adj);
+    fetx_netlist_map_delete(tmp_map);
+    fetx_dealloc(s.node_new);
+    fetx_dealloc(s.fet_new);
+    return FETX_ERR_ALLOC;
+  }
+
+  size_t i = 0;
+  while (i < nl.nodes_size) {
+    s.node_new[i] = nl.nodes_size;
+    ++i;
+  }
+  i = 0;
+  while (i < nl.fl.size) {
+    s.fet_new[i] = nl.fl.size;
+    ++i;
+  }
+
+  /* inputs first, in input order, then the supplies */
+  i = 0;
+  while (i < nl.inputs_size) {
+    fetx_netlist_reorder_node(&s, nl.inputs[i]);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.supplies_size) {
+    fetx_netlist_reorder_node(&s, nl.supplies[i].node);
+    ++i;
+  }
+  const size_t inputs_end = s.nodes_tail;
+
+  /* seed with what the inputs drive through gates, then through channels */
+  unsigned char through_gate = 1;
+  do {
+    i = 0;
+    while (i < inputs_end) {
+      const size_t node = tmp_map.nodes[i];
+      size_t a = adj.offsets[node];
+      while (a < adj.offsets[node + 1]) {
+        const struct fetx_fetlist_fet fet = nl.fl.fets[adj.fets[a]];
+        if ((fet.connections[0] == node) == through_gate) {
+          fetx_netlist_reorder_node(&s, fet.connections[1]);
+          fetx_netlist_reorder_node(&s, fet.connections[2]);
+        }
+        ++a;
+      }
+      ++i;
+    }
+    through_gate = !through_gate;
+  } while (through_gate == 0);
+
+  /* breadth first through the internal nodes, restarting from the lowest
+   * unreached node for parts of the circuit the inputs do not reach */
+  size_t head = inputs_end;
+  size_t unreached = 0;
+  while (head < nl.nodes_size) {
+    if (head == s.nodes_tail) {
+      while (s.node_new[unreached] != nl.nodes_size) {
+        ++unreached;
+      }
+      fetx_netlist_reorder_node(&s, unreached);
+    }
+    const size_t node = tmp_map.nodes[head];
+    size_t a = adj.offsets[node];
+    while (a < adj.offsets[node + 1]) {
+      const size_t f = adj.fets[a];
+      fetx_netlist_reorder_fet(&s, f);
+      unsigned char c = 0;
+      while (c < 3) {
+        fetx_netlist_reorder_node(&s, nl.fl.fets[f].connections[c]);
+        ++c;
+      }
+      ++a;
+    }
+    ++head;
+  }
+  /* FETs between inputs only */
+  i = 0;
+  while (i < nl.fl.size) {
+    fetx_netlist_reorder_fet(&s, i);
+    ++i;
+  }
+  fetx_netlist_adj_delete(adj);
+
+  enum fetx_errs errs = fetx_netlist_new_as(out, nl);
+  if (errs != FETX_ERR_NONE) {
+    fetx_netlist_map_delete(tmp_map);
+    fetx_dealloc(s.node_new);
+    fetx_dealloc(s.fet_new);
+    return errs;
+  }
+
+  i = 0;
+  while (i < nl.fl.size) {
+    struct fetx_fetlist_fet fet = nl.fl.fets[tmp_map.fets[i]];
+    unsigned char c = 0;
+    while (c < 3) {
+      fet.connections[c] = s.node_new[fet.connections[c]];
+      ++c;
+    }
+    fetx_netlist_assign_fet(out, fet, i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.inputs_size) {
+    fetx_netlist_assign_input(out, s.node_new[nl.inputs[i]], i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.outputs_size) {
+    fetx_netlist_assign_output(out, s.node_new[nl.outputs[i]], i);
+    ++i;
+  }
+  fetx_netlist_supplies_map(out, nl, s.node_new);
+
+  fetx_dealloc(s.node_new);
+  fetx_dealloc(s.fet_new);
+  if (map != 0) {
+    *map = tmp_map;
+  } else {
+    fetx_netlist_map_delete(tmp_map);
+  }
+  return FETX_ERR_NONE;
+}
+
+/* keeps only the transitive fan-in of the outputs at the indices \outputs in
+ * \nl.outputs, which become the outputs of \out in that order. A node
+ * depends on every FET on its channel, and so on the other side of the
+ * channel and on the gate. Inputs are kept as the boundary and, as when
+ * reordering, not expanded through, so every input of \nl is still an input
+ * of \out and a vector for \nl still applies. The observed outputs then
+ * match \nl except where an input is driven against another through the
+ * pruned FETs. \map may be 0, otherwise it receives the original index of
+ * each node and FET in \out */
+
+enum fetx_errs fetx_netlist_cone(struct fetx_netlist *const out,
+                                 struct fetx_netlist_map *const map,
+                                 const struct fetx_netlist nl,
+                                 const size_t *const outputs,
+                                 const size_t outputs_size) {
+  if (outputs_size == 0) {
+    return FETX_ERR_PARAM;
+  }
+  size_t i = 0;
+  while (i < outputs_size) {
+    if (outputs[i] >= nl.outputs_size) {
+      return FETX_ERR_PARAM;
+    }
+    ++i;
+  }
+
+  struct fetx_netlist_map tmp_map = {.nodes_size = nl.nodes_size,
+                                     .fets_size = nl.fl.size};
+  struct fetx_netlist_reorder_state s = {.map = &tmp_map};
+  struct fetx_netlist_adj adj;
+  if (fetx_netlist_adj_init(&adj, nl) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+  tmp_map.nodes = fetx_alloc(sizeof(*tmp_map.nodes), nl.nodes_size);
+  tmp_map.fets = fetx_alloc(sizeof(*tmp_map.fets), nl.fl.size);
+  s.node_new = fetx_alloc(sizeof(*s.node_new), nl.nodes_size);
+  s.fet_new = fetx_alloc(sizeof(*s.fet_new), nl.fl.size);
+  unsigned char *const is_input =
+      fetx_calloc(nl.nodes_size, sizeof(*is_input));
+  if ((tmp_map.nodes == 0) || (tmp_map.fets == 0) || (s.node_new == 0) ||
+      (s.fet_new == 0) || (is_input == 0)) {
+    fetx_netlist_adj_delete(adj);
+    fetx_netlist_map_delete(tmp_map);
+    fetx_dealloc(s.node_new);
+    fetx_dealloc(s.fet_new);
+    fetx_dealloc(is_input);
+    return FETX_ERR_ALLOC;
+  }
+
+  i = 0;
+  while (i < nl.nodes_size) {
+    s.node_new[i] = nl.nodes_size;
+    ++i;
+  }
+  i = 0;
+  while (i < nl.fl.size) {
+    s.fet_new[i] = nl.fl.size;
+    ++i;
+  }
+
+  /* inputs first, in input order, then the supplies */
+  i = 0;
+  while (i < nl.inputs_size) {
+    fetx_netlist_reorder_node(&s, nl.inputs[i]);
+    is_input[nl.inputs[i]] = 1;
+    ++i;
+  }
+  i = 0;
+  while (i < nl.supplies_size) {
+    fetx_netlist_reorder_node(&s, nl.supplies[i].node);
+    is_input[nl.supplies[i].node] = 1;
+    ++i;
+  }
+  const size_t inputs_end = s.nodes_tail;
+  i = 0;
+  while (i < outputs_size) {
+    fetx_netlist_reorder_node(&s, nl.outputs[outputs[i]]);
+    ++i;
+  }
+
+  /* breadth first from the outputs over the channels of the internal nodes,
+   * \map->nodes is the queue */
+  size_t head = inputs_end;
+  while (head < s.nodes_tail) {
+    const size_t node = tmp_map.nodes[head];
+    if (is_input[node] == 0) {
+      size_t a = adj.offsets[node];
+      while (a < adj.offsets[node + 1]) {
+        const size_t f = adj.fets[a];
+        const struct fetx_fetlist_fet fet = nl.fl.fets[f];
+        if ((fet.connections[1] == node) || (fet.connections[2] == node)) {
+          fetx_netlist_reorder_fet(&s, f);
+          unsigned char c = 0;
+          while (c < 3) {
+            fetx_netlist_reorder_node(&s, fet.connections[c]);
+            ++c;
+          }
+        }
+        ++a;
+      }
+    }
+    ++head;
+  }
+  fetx_netlist_adj_delete(adj);
+  fetx_dealloc(is_input);
+
+  const struct fetx_netlist sizes = {.fl.size = s.fets_tail,
+                                     .inputs_size = nl.inputs_size,
+                                     .outputs_size = outputs_size,
+                                     .supplies_size = nl.supplies_size,
+                                     .nodes_size = s.nodes_tail};
+  enum fetx_errs errs = fetx_netlist_new_as(out, sizes);
+  if (errs != FETX_ERR_NONE) {
+    fetx_netlist_map_delete(tmp_map);
+    fetx_dealloc(s.node_new);
+    fetx_dealloc(s.fet_new);
+    return errs;
+  }
+
+  i = 0;
+  while (i < s.fets_tail) {
+    struct fetx_fetlist_fet fet = nl.fl.fets[tmp_map.fets[i]];
+    unsigned char c = 0;
+    while (c < 3) {
+      fet.connections[c] = s.node_new[fet.connections[c]];
+      ++c;
+    }
+    fetx_netlist_assign_fet(out, fet, i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.inputs_size) {
+    fetx_netlist_assign_input(out, s.node_new[nl.inputs[i]], i);
+    ++i;
+  }
+  i = 0;
+  while (i < outputs_size) {
+    fetx_netlist_assign_output(out, s.node_new[nl.outputs[outputs[i]]], i);
+    ++i;
+  }
+  fetx_netlist_supplies_map(out, nl, s.node_new);
+
+  tmp_map.nodes_size = s.nodes_tail;
+  tmp_map.fets_size = s.fets_tail;
+  fetx_dealloc(s.node_new);
+  fetx_dealloc(s.fet_new);
+  if (map != 0) {
+    *map = tmp_map;
+  } else {
+    fetx_netlist_map_delete(tmp_map);
+  }
+  return FETX_ERR_NONE;
+}
+
+/* union find root of \node, halving the path as it goes */
+
+static size_t fetx_netlist_fold_find(size_t *const parents, size_t node) {
+  while (parents[node] != node) {
+    parents[node] = parents[parents[node]];
+    node = parents[node];
+  }
+  return node;
+}
+
+/* removes the FETs held off by a supply and merges a free node into a supply
+ * through a FET held on that passes its level, an N FET to a low supply or a
+ * P FET to a high one, repeating while merges tie more gates to a supply.
+ * Other FETs held on still pass only one level so are kept, except between
+ * supplies at the same level. Nodes are renumbered in order. Paths end at
+ * supplies, so a node merged into one only loses the states of paths that
+ * drove it against its level. \map may be 0, otherwise it
+ * receives the original index of each node and FET in \out, a merged node
+ * mapping to the lowest of its nodes that is kept */
+
+enum fetx_errs fetx_netlist_fold(struct fetx_netlist *const out,
+                                 struct fetx_netlist_map *const map,
+                                 const struct fetx_netlist nl) {
+  struct fetx_netlist_map tmp_map = {.nodes_size = 0, .fets_size = 0};
+  size_t *const parents = fetx_alloc(sizeof(*parents), nl.nodes_size);
+  /* per node, 0 for a free node, 1 for an input or the level + 2 */
+  unsigned char *const kinds = fetx_calloc(nl.nodes_size, sizeof(*kinds));
+  unsigned char *const fet_kept = fetx_alloc(sizeof(*fet_kept), nl.fl.size);
+  size_t *const node_new = fetx_alloc(sizeof(*node_new), nl.nodes_size);
+  tmp_map.nodes = fetx_alloc(sizeof(*tmp_map.nodes), nl.nodes_size);
+  tmp_map.fets = fetx_alloc(sizeof(*tmp_map.fets), nl.fl.size);
+  if ((parents == 0) || (kinds == 0) || (fet_kept == 0) || (node_new == 0) ||
+      (tmp_map.nodes == 0) || (tmp_map.fets == 0)) {
+    fetx_dealloc(parents);
+    fetx_dealloc(kinds);
+    fetx_dealloc(fet_kept);
+    fetx_dealloc(node_new);
+    fetx_netlist_map_delete(tmp_map);
+    return FETX_ERR_ALLOC;
+  }
+
+  size_t i = 0;
+  while (i < nl.nodes_size) {
+    parents[i] = i;
+    node_new[i] = nl.nodes_size;
+    ++i;
+  }
+  i = 0;
+  while (i < nl.inputs_size) {
+    kinds[nl.inputs[i]] = 1;
+    ++i;
+  }
+  i = 0;
+  while (i < nl.supplies_size) {
+    kinds[nl.supplies[i].node] = (unsigned char)(nl.supplies[i].state + 2);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.fl.size) {
+    fet_kept[i] = 1;
+    ++i;
+  }
+
+  unsigned char changed = 1;
+  while (changed != 0) {
+    changed = 0;
+    size_t f = 0;
+    while (f < nl.fl.size) {
+      const struct fetx_fetlist_fet fet = nl.fl.fets[f];
+      const unsigned char gate =
+          kinds[fetx_netlist_fold_find(parents, fet.connections[0])];
+      if ((fet_kept[f] != 0) && (gate >= 2)) {
+        const size_t a = fetx_netlist_fold_find(parents, fet.connections[1]);
+        const size_t b = fetx_netlist_fold_find(parents, fet.connections[2]);
+        const unsigned char on =
+            ((fet.type == FETX_FET_N) == ((gate - 2) == FETX_HIGH)) ? 1 : 0;
+        /* the kind of the supply the FET passes */
+        const unsigned char passes =
+            (unsigned char)(((fet.type == FETX_FET_N) ? FETX_LOW : FETX_HIGH) +
+                            2);
+        if ((on == 0) || (a == b)) {
+          fet_kept[f] = 0;
+          changed = 1;
+        } else if (((kinds[a] == kinds[b]) && (kinds[a] >= 2)) ||
+                   ((kinds[a] == 0) && (kinds[b] == passes)) ||
+                   ((kinds[b] == 0) && (kinds[a] == passes))) {
+          /* the lower index is kept so the merge is deterministic */
+          const size_t keep = (a < b) ? a : b;
+          const size_t drop = (a < b) ? b : a;
+          parents[drop] = keep;
+          kinds[keep] = (kinds[a] > kinds[b]) ? kinds[a] : kinds[b];
+          fet_kept[f] = 0;
+          changed = 1;
+        }
+      }
+      ++f;
+    }
+  }
+  fetx_dealloc(kinds);
+
+  /* number the kept nodes in order, then the kept FETs */
+  size_t nodes_size = 0;
+  i = 0;
+  while (i < nl.nodes_size) {
+    if (fetx_netlist_fold_find(parents, i) == i) {
+      node_new[i] = nodes_size;
+      tmp_map.nodes[nodes_size] = i;
+      ++nodes_size;
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < nl.nodes_size) {
+    node_new[i] = node_new[fetx_netlist_fold_find(parents, i)];
+    ++i;
+  }
+  fetx_dealloc(parents);
+  size_t fets_size = 0;
+  i = 0;
+  while (i < nl.fl.size) {
+    if (fet_kept[i] != 0) {
+      tmp_map.fets[fets_size] = i;
+      ++fets_size;
+    }
+    ++i;
+  }
+  fetx_dealloc(fet_kept);
+
+  struct fetx_netlist sizes = nl;
+  sizes.fl.size = fets_size;
+  sizes.nodes_size = nodes_size;
+  enum fetx_errs errs = fetx_netlist_new_as(out, sizes);
+  if (errs != FETX_ERR_NONE) {
+    fetx_netlist_map_delete(tmp_map);
+    fetx_dealloc(node_new);
+    return errs;
+  }
+
+  i = 0;
+  while (i < fets_size) {
+    struct fetx_fetlist_fet fet = nl.fl.fets[tmp_map.fets[i]];
+    unsigned char c = 0;
+    while (c < 3) {
+      fet.connections[c] = node_new[fet.connections[c]];
+      ++c;
+    }
+    fetx_netlist_assign_fet(out, fet, i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.inputs_size) {
+    fetx_netlist_assign_input(out, node_new[nl.inputs[i]], i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.outputs_size) {
+    fetx_netlist_assign_output(out, node_new[nl.outputs[i]], i);
+    ++i;
+  }
+  fetx_netlist_supplies_map(out, nl, node_new);
+  fetx_dealloc(node_new);
+
+  tmp_map.nodes_size = nodes_size;
+  tmp_map.fets_size = fets_size;
+  if (map != 0) {
+    *map = tmp_map;
+  } else {
+    fetx_netlist_map_delete(tmp_map);
+  }
+  return FETX_ERR_NONE;
+}
+
 enum fetx_netlist_line_type {
   fetx_netlist_line_unknown,
   fetx_netlist_line_inputs,
   fetx_netlist_line_outputs,
-  fetx_netlist_line_fet
+  fetx_netlist_line_supplies,
+  fetx_netlist_line_fet,
+  fetx_netlist_line_delays,     /* FET index and delay pairs */
+  fetx_netlist_line_type_delays /* n then p delay */
 };
 
 /* reset the sizes in \nl after allocating and re-use them as an index */
@@ -93,6 +723,12 @@ static int fetx_netlist_file_stride(struct fetx_netlist *const nl,
           ++nl->inputs_size;
         } else if (type == fetx_netlist_line_outputs) {
           ++nl->outputs_size;
+        } else if (type == fetx_netlist_line_supplies) {
+          ++nl->supplies_size;
+        } else if (type == fetx_netlist_line_delays) {
+          count = (count == 0) ? 1 : 0;
+        } else if ((type == fetx_netlist_line_type_delays) && (count < 2)) {
+          ++count;
         } else {
           return -1;
         }
@@ -101,28 +737,42 @@ static int fetx_netlist_file_stride(struct fetx_netlist *const nl,
       if (c == EOF) {
         break;
       } else if ((c != ' ') && (c != '\t') && (c != '\n') && (c != '\r')) {
-        if (count != 0) {
+        if ((count != 0) && ((type != fetx_netlist_line_type_delays) ||
+                             (count != 2))) {
           return -1;
         }
+        count = 0;
         if ((c == 'p') || (c == 'n')) {
           type = fetx_netlist_line_fet;
         } else if (c == 'i') {
           type = fetx_netlist_line_inputs;
         } else if (c == 'o') {
           type = fetx_netlist_line_outputs;
+        } else if ((c == 'g') || (c == 'v')) {
+          type = fetx_netlist_line_supplies;
+        } else if (c == 'd') {
+          type = fetx_netlist_line_delays;
+        } else if (c == 't') {
+          type = fetx_netlist_line_type_delays;
         } else {
           return -1;
         }
       }
     }
   }
-  return 0;
+  return (((type == fetx_netlist_line_delays) && (count != 0)) ||
+          ((type == fetx_netlist_line_type_delays) && (count == 1)))
+             ? -1
+             : 0;
 }
 
 static int fetx_netlist_file_proc(struct fetx_netlist *const nl,
                                   FILE *const fd) {
   enum fetx_netlist_line_type type = fetx_netlist_line_unknown;
   enum fetx_fet_types fet_type;
+  enum fetx_node_states supply_state = FETX_LOW;
+  unsigned int type_delays[2] = {0, 0};
+  size_t delay_fet = 0;
   unsigned char nw = 0;
   unsigned char count = 0;
   size_t value = 0;
@@ -146,6 +796,7 @@ static int fetx_netlist_file_proc(struct fetx_netlist *const nl,
           nl->fl.fets[nl->fl.size].connections[count] = value;
           if (count == 2) {
             nl->fl.fets[nl->fl.size].type = fet_type;
+            nl->fl.fets[nl->fl.size].delay = 0;
             ++nl->fl.size;
             count = 0;
           } else {
@@ -157,6 +808,31 @@ static int fetx_netlist_file_proc(struct fetx_netlist *const nl,
         } else if (type == fetx_netlist_line_outputs) {
           nl->outputs[nl->outputs_size] = value;
           ++nl->outputs_size;
+        } else if (type == fetx_netlist_line_supplies) {
+          nl->supplies[nl->supplies_size].node = value;
+          nl->supplies[nl->supplies_size].state = supply_state;
+          ++nl->supplies_size;
+        } else if (type == fetx_netlist_line_delays) {
+          /* the FET must come before its delay */
+          if (count == 0) {
+            if (value >= nl->fl.size) {
+              return -1;
+            }
+            delay_fet = value;
+            count = 1;
+          } else {
+            if (value > UINT_MAX) {
+              return -1;
+            }
+            nl->fl.fets[delay_fet].delay = (unsigned int)value;
+            count = 0;
+          }
+        } else if (type == fetx_netlist_line_type_delays) {
+          if (value > UINT_MAX) {
+            return -1;
+          }
+          type_delays[count] = (unsigned int)value;
+          ++count;
         } else {
           return -1;
         }
@@ -167,6 +843,7 @@ static int fetx_netlist_file_proc(struct fetx_netlist *const nl,
       if (c == EOF) {
         break;
       } else if ((c != ' ') && (c != '\t') && (c != '\n') && (c != '\r')) {
+        count = 0;
         if (c == 'p') {
           fet_type = FETX_FET_P;
           type = fetx_netlist_line_fet;
@@ -177,12 +854,31 @@ static int fetx_netlist_file_proc(struct fetx_netlist *const nl,
           type = fetx_netlist_line_inputs;
         } else if (c == 'o') {
           type = fetx_netlist_line_outputs;
+        } else if (c == 'g') {
+          supply_state = FETX_LOW;
+          type = fetx_netlist_line_supplies;
+        } else if (c == 'v') {
+          supply_state = FETX_HIGH;
+          type = fetx_netlist_line_supplies;
+        } else if (c == 'd') {
+          type = fetx_netlist_line_delays;
+        } else if (c == 't') {
+          type = fetx_netlist_line_type_delays;
         } else {
           return -1;
         }
       }
     }
   }
+
+  /* FETs without a delay of their own take that of their type */
+  size_t f = 0;
+  while (f < nl->fl.size) {
+    if (nl->fl.fets[f].delay == 0) {
+      nl->fl.fets[f].delay = type_delays[nl->fl.fets[f].type];
+    }
+    ++f;
+  }
   return 0;
 }
 
@@ -196,6 +892,7 @@ enum fetx_errs fetx_netlist_from_file(struct fetx_netlist *const nl,
   nl->fl.size = 0;
   nl->inputs_size = 0;
   nl->outputs_size = 0;
+  nl->supplies_size = 0;
 
   if (fetx_netlist_file_stride(nl, fd) != 0) {
     return (fclose(fd) != 0) ? FETX_ERR_FFORMAT | FETX_ERR_FCLOSE
@@ -214,6 +911,7 @@ enum fetx_errs fetx_netlist_from_file(struct fetx_netlist *const nl,
   nl->fl.size = 0;
   nl->inputs_size = 0;
   nl->outputs_size = 0;
+  nl->supplies_size = 0;
 
   if (fetx_netlist_file_proc(nl, fd) != 0) {
     return (fclose(fd) != 0) ? FETX_ERR_FFORMAT | FETX_ERR_FCLOSE
@@ -260,6 +958,31 @@ enum fetx_errs fetx_netlist_to_fd(const struct fetx_netlist nl,
     return FETX_ERR_IO;
   }
 
+  /* supplies, a line for each level */
+  unsigned char high = 0;
+  while (high < 2) {
+    const enum fetx_node_states state = (high != 0) ? FETX_HIGH : FETX_LOW;
+    unsigned char any = 0;
+    f = 0;
+    while (f < nl.supplies_size) {
+      if (nl.supplies[f].state == state) {
+        if ((any == 0) && (fprintf(fd, (high != 0) ? "v" : "g") < 0)) {
+          return FETX_ERR_IO;
+        }
+        any = 1;
+        if (fprintf(fd, " %llu",
+                    (unsigned long long int)nl.supplies[f].node) < 0) {
+          return FETX_ERR_IO;
+        }
+      }
+      ++f;
+    }
+    if ((any != 0) && (fprintf(fd, "\n") < 0)) {
+      return FETX_ERR_IO;
+    }
+    ++high;
+  }
+
   f = 0;
   while (f < nl.fl.size) {
     if (fprintf(fd, "%c %llu %llu %llu\n",
@@ -271,6 +994,25 @@ enum fetx_errs fetx_netlist_to_fd(const struct fetx_netlist nl,
     }
     ++f;
   }
+
+  unsigned char any = 0;
+  f = 0;
+  while (f < nl.fl.size) {
+    if (nl.fl.fets[f].delay > 1) {
+      if ((any == 0) && (fprintf(fd, "d") < 0)) {
+        return FETX_ERR_IO;
+      }
+      any = 1;
+      if (fprintf(fd, " %llu %u", (long long unsigned int)f,
+                  nl.fl.fets[f].delay) < 0) {
+        return FETX_ERR_IO;
+      }
+    }
+    ++f;
+  }
+  if ((any != 0) && (fprintf(fd, "\n") < 0)) {
+    return FETX_ERR_IO;
+  }
   return FETX_ERR_NONE;
 }
 
@@ -27,16 +27,37 @@ enum fetx_errs {
   FETX_ERR_FCLOSE = 8,
   FETX_ERR_FFORMAT = 16,
   FETX_ERR_IO = 32,
-  FETX_ERR_TIMEOUT = 64
+  FETX_ERR_TIMEOUT = 64,
+  FETX_ERR_BUDGET = 128,
+  FETX_ERR_MISMATCH = 256
+};
+
+/* a node held at a fixed level for the whole simulation */
+
+struct fetx_netlist_supply {
+  size_t node;
+  enum fetx_node_states state; /* FETX_LOW or FETX_HIGH */
 };
 
 struct fetx_netlist {
   struct fetx_fetlist fl;
   size_t *inputs;
   size_t *outputs;
+  struct fetx_netlist_supply *supplies;
   size_t nodes_size;
   size_t inputs_size;
   size_t outputs_size;
+  size_t supplies_size;
+};
+
+/* maps the node and FET indices of a generated netlist back to the indices in
+ * the netlist it was generated from */
+
+struct fetx_netlist_map {
+  size_t *nodes;
+  size_t *fets;
+  size_t nodes_size;
+  size_t fets_size;
 };
 
 void fetx_netlist_delete(struct fetx_netlist nl);
@@ -48,8 +69,25 @@ void fetx_netlist_assign_input(struct fetx_netlist *const nl,
                                const size_t node_index, const size_t index);
 void fetx_netlist_assign_output(struct fetx_netlist *const nl,
                                 const size_t node_index, const size_t index);
+void fetx_netlist_assign_supply(struct fetx_netlist *const nl,
+                                const struct fetx_netlist_supply supply,
+                                const size_t index);
 void fetx_netlist_update_nodes_size(struct fetx_netlist *const nl);
 
+void fetx_netlist_map_delete(struct fetx_netlist_map map);
+enum fetx_errs fetx_netlist_reorder(struct fetx_netlist *const out,
+                                    struct fetx_netlist_map *const map,
+                                    const struct fetx_netlist nl);
+enum fetx_errs fetx_netlist_cone(struct fetx_netlist *const out,
+                                 struct fetx_netlist_map *const map,
+                                 const struct fetx_netlist nl,
+                                 const size_t *const outputs,
+                                 const size_t outputs_size);
+
+enum fetx_errs fetx_netlist_fold(struct fetx_netlist *const out,
+                                 struct fetx_netlist_map *const map,
+                                 const struct fetx_netlist nl);
+
 enum fetx_errs fetx_netlist_from_file(struct fetx_netlist *const nl,
                                       const char *const pathname);
 enum fetx_errs fetx_netlist_to_file(const struct fetx_netlist nl,
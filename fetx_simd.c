@@ -0,0 +1,134 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_simd.h"
+
+/* the vector kernels are picked at run time on x86 and always used on 64 bit
+ * ARM, FETX_NO_SIMD leaves only the scalar kernel */
+
+#if !defined(FETX_NO_SIMD) && defined(__GNUC__) &&                            \
+    (defined(__x86_64__) || defined(__i386__))
+#define FETX_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(FETX_NO_SIMD) && defined(__aarch64__)
+#define FETX_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+static unsigned long int
+fetx_fet_states_block_scalar(unsigned char *const states,
+                             const unsigned char *const keys, const size_t size,
+                             const unsigned char *const table) {
+  unsigned long int changed = 0;
+  size_t i = 0;
+  while (i < size) {
+    const unsigned char state = table[keys[i]];
+    if (state != states[i]) {
+      states[i] = state;
+      changed |= 1ul << i;
+    }
+    ++i;
+  }
+  return changed;
+}
+
+#if defined(FETX_SIMD_AVX2) || defined(FETX_SIMD_NEON)
+
+static unsigned long int fetx_block_mask(const size_t size) {
+  return (size < FETX_SIMD_BLOCK) ? (1ul << size) - 1 : 0xfffffffful;
+}
+
+#endif
+
+#ifdef FETX_SIMD_AVX2
+
+__attribute__((target("avx2"))) static unsigned long int
+fetx_fet_states_block_avx2(unsigned char *const states,
+                           const unsigned char *const keys, const size_t size,
+                           const unsigned char *const table) {
+  const __m256i table_n = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)table));
+  const __m256i table_p = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)(table + 16)));
+  const __m256i k = _mm256_loadu_si256((const __m256i *)keys);
+  const __m256i masks = _mm256_and_si256(k, _mm256_set1_epi8(0x0f));
+  const __m256i is_p = _mm256_cmpeq_epi8(
+      _mm256_and_si256(k, _mm256_set1_epi8(0x10)), _mm256_set1_epi8(0x10));
+  const __m256i s = _mm256_blendv_epi8(_mm256_shuffle_epi8(table_n, masks),
+                                       _mm256_shuffle_epi8(table_p, masks),
+                                       is_p);
+  const __m256i old = _mm256_loadu_si256((const __m256i *)states);
+  const unsigned long int same =
+      (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, old));
+  _mm256_storeu_si256((__m256i *)states, s);
+  return ~same & fetx_block_mask(size);
+}
+
+#endif
+
+#ifdef FETX_SIMD_NEON
+
+static unsigned long int fetx_changed_bits_neon(const uint8x16_t same) {
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t bits = vandq_u8(vmvnq_u8(same), vld1q_u8(weights));
+  return vaddv_u8(vget_low_u8(bits)) |
+         ((unsigned long int)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+static unsigned long int
+fetx_fet_states_block_neon(unsigned char *const states,
+                           const unsigned char *const keys, const size_t size,
+                           const unsigned char *const table) {
+  const uint8x16_t table_n = vld1q_u8(table);
+  const uint8x16_t table_p = vld1q_u8(table + 16);
+  unsigned long int changed = 0;
+  size_t i = 0;
+  while (i < FETX_SIMD_BLOCK) {
+    const uint8x16_t k = vld1q_u8(keys + i);
+    const uint8x16_t masks = vandq_u8(k, vdupq_n_u8(0x0f));
+    const uint8x16_t is_p = vtstq_u8(k, vdupq_n_u8(0x10));
+    const uint8x16_t s = vbslq_u8(is_p, vqtbl1q_u8(table_p, masks),
+                                  vqtbl1q_u8(table_n, masks));
+    const uint8x16_t old = vld1q_u8(states + i);
+    changed |= fetx_changed_bits_neon(vceqq_u8(s, old)) << i;
+    vst1q_u8(states + i, s);
+    i += 16;
+  }
+  return changed & fetx_block_mask(size);
+}
+
+#endif
+
+/* looks up the new state of each FET in a block. \keys holds
+ * (type << 4) | control state_mask for each FET, \table the state for each
+ * key and \states the current states, which are overwritten with the new
+ * ones. Entries from \size up to FETX_SIMD_BLOCK may be read and written but
+ * are ignored. Returns a bit per FET whose state changed. */
+
+unsigned long int fetx_fet_states_block(unsigned char *const states,
+                                        const unsigned char *const keys,
+                                        const size_t size,
+                                        const unsigned char *const table) {
+#if defined(FETX_SIMD_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return fetx_fet_states_block_avx2(states, keys, size, table);
+  }
+#elif defined(FETX_SIMD_NEON)
+  return fetx_fet_states_block_neon(states, keys, size, table);
+#endif
+  return fetx_fet_states_block_scalar(states, keys, size, table);
+}
@@ -0,0 +1,31 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_SIMD_H
+#define FETX_SIMD_H
+
+#include <stddef.h>
+
+/* FETs are evaluated in blocks of up to this many, the block buffers must
+ * always be this size */
+#define FETX_SIMD_BLOCK 32
+
+unsigned long int fetx_fet_states_block(unsigned char *const states,
+                                        const unsigned char *const keys,
+                                        const size_t size,
+                                        const unsigned char *const table);
+
+#endif
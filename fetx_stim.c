@@ -0,0 +1,142 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_stim.h"
+
+void fetx_stim_delete(struct fetx_stim stim) { fetx_dealloc(stim.row); }
+
+/* xorshift64*, which never leaves a nonzero state */
+
+static unsigned long long int fetx_stim_random(struct fetx_stim *const stim) {
+  unsigned long long int x = stim->state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  stim->state = x;
+  return x * 0x2545f4914f6cdd1dull;
+}
+
+static enum fetx_stim_columns
+fetx_stim_column(const struct fetx_stim *const stim, const size_t column) {
+  return (stim->columns != 0) ? stim->columns[column] : FETX_STIM_FREE;
+}
+
+/* starts again from the first row */
+
+void fetx_stim_reset(struct fetx_stim *const stim) {
+  /* spread the seed over the state, 0 would stick at 0 */
+  unsigned long long int x = stim->seed + 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  stim->state = (x != 0) ? x : 0x9e3779b97f4a7c15ull;
+  stim->rows_size = 0;
+
+  size_t i = 0;
+  while (i < stim->width) {
+    const enum fetx_stim_columns column = fetx_stim_column(stim, i);
+    stim->row[i] = (column == FETX_STIM_HIGH) ? FETX_HIGH : FETX_LOW;
+    ++i;
+  }
+}
+
+/* \columns gives what drives each of the \width columns and must last as
+ * long as \stim, 0 leaves them all free. Gray code rows are limited to 63
+ * free columns, or 62 with a clock, so that their length fits. */
+
+enum fetx_errs fetx_stim_new(struct fetx_stim *const stim,
+                             const enum fetx_stim_kinds kind,
+                             const enum fetx_stim_columns *const columns,
+                             const size_t width,
+                             const unsigned long long int seed) {
+  stim->kind = kind;
+  stim->columns = columns;
+  stim->width = width;
+  stim->seed = seed;
+  stim->free_size = 0;
+  stim->is_clocked = 0;
+  size_t i = 0;
+  while (i < width) {
+    const enum fetx_stim_columns column = fetx_stim_column(stim, i);
+    if (column == FETX_STIM_FREE) {
+      ++stim->free_size;
+    } else if (column == FETX_STIM_CLOCK) {
+      stim->is_clocked = 1;
+    }
+    ++i;
+  }
+  if ((kind == FETX_STIM_GRAY) &&
+      (stim->free_size > (size_t)(63 - stim->is_clocked))) {
+    return FETX_ERR_PARAM;
+  }
+  stim->row = fetx_alloc(sizeof(*stim->row), width);
+  if ((stim->row == 0) && (width != 0)) {
+    return FETX_ERR_ALLOC;
+  }
+  fetx_stim_reset(stim);
+  return FETX_ERR_NONE;
+}
+
+/* the rows before Gray code rows start again from the first, 0 for random
+ * rows which don't end */
+
+unsigned long long int fetx_stim_length(const struct fetx_stim *const stim) {
+  if (stim->kind != FETX_STIM_GRAY) {
+    return 0;
+  }
+  return (1ull << stim->free_size) << stim->is_clocked;
+}
+
+/* generates the next row, which is valid until the next call */
+
+const enum fetx_node_states *fetx_stim_next(struct fetx_stim *const stim) {
+  const unsigned long long int t = stim->rows_size;
+  ++stim->rows_size;
+  /* a clocked value is held for the high half of its cycle */
+  const int is_high = (stim->is_clocked != 0) && ((t & 1) != 0);
+  if (is_high == 0) {
+    unsigned long long int index = (stim->is_clocked != 0) ? (t >> 1) : t;
+    if (stim->kind == FETX_STIM_GRAY) {
+      /* wraps, the last and first rows differ in one column too */
+      index &= (1ull << stim->free_size) - 1;
+    }
+    unsigned long long int bits = index ^ (index >> 1);
+    unsigned int bits_used = 64;
+    size_t i = 0;
+    while (i < stim->width) {
+      if (fetx_stim_column(stim, i) == FETX_STIM_FREE) {
+        if (stim->kind == FETX_STIM_RANDOM) {
+          if (bits_used == 64) {
+            bits = fetx_stim_random(stim);
+            bits_used = 0;
+          }
+          ++bits_used;
+        }
+        stim->row[i] = ((bits & 1) != 0) ? FETX_HIGH : FETX_LOW;
+        bits >>= 1;
+      }
+      ++i;
+    }
+  }
+  size_t i = 0;
+  while ((stim->is_clocked != 0) && (i < stim->width)) {
+    if (fetx_stim_column(stim, i) == FETX_STIM_CLOCK) {
+      stim->row[i] = (is_high != 0) ? FETX_HIGH : FETX_LOW;
+    }
+    ++i;
+  }
+  return stim->row;
+}
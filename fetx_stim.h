@@ -0,0 +1,63 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_STIM_H
+#define FETX_STIM_H
+
+#include "fetx_netlist.h"
+
+/* input rows generated as they are simulated rather than read from a vector
+ * file. Random rows come from a seeded xorshift generator, exhaustive ones
+ * count through every combination in Gray code order so that one input
+ * changes per row. */
+
+enum fetx_stim_kinds { FETX_STIM_RANDOM = 0, FETX_STIM_GRAY };
+
+/* what drives each input column */
+
+enum fetx_stim_columns {
+  FETX_STIM_FREE = 0, /* from the generator */
+  FETX_STIM_LOW,
+  FETX_STIM_HIGH,
+  /* low then high for each value of the free columns, which hold their
+   * values while it is high */
+  FETX_STIM_CLOCK
+};
+
+struct fetx_stim {
+  enum fetx_stim_kinds kind;
+  const enum fetx_stim_columns *columns; /* 0 for every column free */
+  size_t width;
+  unsigned long long int seed;
+  /* the row last generated */
+  enum fetx_node_states *row;
+  unsigned long long int rows_size; /* generated since the start */
+  unsigned long long int state;     /* of the random generator */
+  size_t free_size;
+  unsigned int is_clocked : 1;
+};
+
+void fetx_stim_delete(struct fetx_stim stim);
+enum fetx_errs fetx_stim_new(struct fetx_stim *const stim,
+                             const enum fetx_stim_kinds kind,
+                             const enum fetx_stim_columns *const columns,
+                             const size_t width,
+                             const unsigned long long int seed);
+void fetx_stim_reset(struct fetx_stim *const stim);
+unsigned long long int fetx_stim_length(const struct fetx_stim *const stim);
+const enum fetx_node_states *fetx_stim_next(struct fetx_stim *const stim);
+
+#endif
@@ -0,0 +1,409 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_trace.h"
+
+#define FETX_TRACE_BUFFER_SIZE 65536
+/* longest single record, a time or a value */
+#define FETX_TRACE_RECORD_MAX 32
+
+/* binary records are varints, the low 3 bits hold the state of the slot in
+ * the upper bits or FETX_TRACE_BIN_TIME for a time step in the upper bits */
+#define FETX_TRACE_BIN_TIME 7
+static const char fetx_trace_bin_magic[8] = {'F', 'E', 'T', 'X',
+                                             'T', 'R', 'C', '\n'};
+
+static void *fetx_trace_writer(void *const arg) {
+  struct fetx_trace *const trace = arg;
+  pthread_mutex_lock(&trace->lock);
+  while (1) {
+    while ((trace->write == 0) && (trace->quit == 0)) {
+      pthread_cond_wait(&trace->cond, &trace->lock);
+    }
+    if (trace->write == 0) {
+      break;
+    }
+    struct fetx_trace_buffer *const buffer = trace->write;
+    pthread_mutex_unlock(&trace->lock);
+    const size_t written = fwrite(buffer->data, 1, buffer->size, trace->fd);
+    pthread_mutex_lock(&trace->lock);
+    if (written != buffer->size) {
+      trace->errs |= FETX_ERR_IO;
+    }
+    buffer->size = 0;
+    trace->write = 0;
+    pthread_cond_broadcast(&trace->cond);
+  }
+  pthread_mutex_unlock(&trace->lock);
+  return 0;
+}
+
+/* passes the filled buffer to the writer once it has finished the other */
+
+static void fetx_trace_handoff(struct fetx_trace *const trace) {
+  pthread_mutex_lock(&trace->lock);
+  while (trace->write != 0) {
+    pthread_cond_wait(&trace->cond, &trace->lock);
+  }
+  trace->write = trace->fill;
+  pthread_cond_broadcast(&trace->cond);
+  pthread_mutex_unlock(&trace->lock);
+  trace->fill = (trace->fill == trace->buffers) ? trace->buffers + 1
+                                                : trace->buffers;
+}
+
+static void fetx_trace_reserve(struct fetx_trace *const trace) {
+  if ((trace->fill->size + FETX_TRACE_RECORD_MAX) > FETX_TRACE_BUFFER_SIZE) {
+    fetx_trace_handoff(trace);
+  }
+}
+
+static void fetx_trace_put(struct fetx_trace *const trace,
+                           const unsigned char c) {
+  trace->fill->data[trace->fill->size] = c;
+  ++trace->fill->size;
+}
+
+static void fetx_trace_put_varint(struct fetx_trace *const trace,
+                                  unsigned long long int value) {
+  while (value >= 0x80) {
+    fetx_trace_put(trace, (unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  fetx_trace_put(trace, (unsigned char)value);
+}
+
+static void fetx_trace_put_decimal(struct fetx_trace *const trace,
+                                   unsigned long int value) {
+  unsigned char digits[20];
+  unsigned char count = 0;
+  do {
+    digits[count] = '0' + (value % 10);
+    value /= 10;
+    ++count;
+  } while (value != 0);
+  while (count > 0) {
+    --count;
+    fetx_trace_put(trace, digits[count]);
+  }
+}
+
+/* VCD identifiers are strings of the printable characters '!' to '~' */
+
+static void fetx_trace_put_id(struct fetx_trace *const trace, size_t slot) {
+  do {
+    fetx_trace_put(trace, '!' + (slot % 94));
+    slot /= 94;
+  } while (slot != 0);
+}
+
+static int fetx_trace_fprint_id(FILE *const fd, size_t slot) {
+  do {
+    if (fputc('!' + (slot % 94), fd) == EOF) {
+      return -1;
+    }
+    slot /= 94;
+  } while (slot != 0);
+  return 0;
+}
+
+static unsigned char fetx_trace_vcd_value(const enum fetx_node_states state) {
+  switch (state) {
+  case FETX_LOW:
+    return '0';
+  case FETX_HIGH:
+    return '1';
+  case FETX_UNDRIVEN:
+    return 'z';
+  default:
+    return 'x';
+  }
+}
+
+static void fetx_trace_put_time(struct fetx_trace *const trace,
+                                const unsigned long int time) {
+  fetx_trace_reserve(trace);
+  if (trace->format == FETX_TRACE_VCD) {
+    fetx_trace_put(trace, '#');
+    fetx_trace_put_decimal(trace, time);
+    fetx_trace_put(trace, '\n');
+  } else {
+    fetx_trace_put_varint(
+        trace,
+        ((unsigned long long int)(time - trace->time) << 3) |
+            FETX_TRACE_BIN_TIME);
+  }
+  trace->time = time;
+}
+
+static void fetx_trace_put_value(struct fetx_trace *const trace,
+                                 const size_t slot,
+                                 const enum fetx_node_states state) {
+  fetx_trace_reserve(trace);
+  if (trace->format == FETX_TRACE_VCD) {
+    fetx_trace_put(trace, fetx_trace_vcd_value(state));
+    fetx_trace_put_id(trace, slot);
+    fetx_trace_put(trace, '\n');
+  } else {
+    fetx_trace_put_varint(trace, ((unsigned long long int)slot << 3) | state);
+  }
+  trace->states[slot] = state;
+}
+
+static int fetx_trace_fprint_varint(FILE *const fd,
+                                    unsigned long long int value) {
+  while (value >= 0x80) {
+    if (fputc((unsigned char)(value | 0x80), fd) == EOF) {
+      return -1;
+    }
+    value >>= 7;
+  }
+  return (fputc((unsigned char)value, fd) == EOF) ? -1 : 0;
+}
+
+/* the binary header is the magic, the number of slots then the node index of
+ * each slot, all as varints */
+
+static enum fetx_errs
+fetx_trace_header(const struct fetx_trace *const trace,
+                  const size_t *const nodes,
+                  const struct fetx_netlist_map *const map) {
+  FILE *const fd = trace->fd;
+  size_t slot = 0;
+  if (trace->format == FETX_TRACE_BIN) {
+    if ((fwrite(fetx_trace_bin_magic, 1, sizeof(fetx_trace_bin_magic), fd) !=
+         sizeof(fetx_trace_bin_magic)) ||
+        (fetx_trace_fprint_varint(fd, trace->nodes_size) != 0)) {
+      return FETX_ERR_IO;
+    }
+    while (slot < trace->nodes_size) {
+      const size_t index = (map != 0) ? map->nodes[nodes[slot]] : nodes[slot];
+      if (fetx_trace_fprint_varint(fd, index) != 0) {
+        return FETX_ERR_IO;
+      }
+      ++slot;
+    }
+    return FETX_ERR_NONE;
+  }
+  if (fprintf(fd, "$comment fetx, time is in resolve steps $end\n"
+                  "$timescale 1ns $end\n$scope module fetx $end\n") < 0) {
+    return FETX_ERR_IO;
+  }
+  while (slot < trace->nodes_size) {
+    const size_t index = (map != 0) ? map->nodes[nodes[slot]] : nodes[slot];
+    if ((fprintf(fd, "$var wire 1 ") < 0) ||
+        (fetx_trace_fprint_id(fd, slot) != 0) ||
+        (fprintf(fd, " n%llu $end\n", (unsigned long long int)index) < 0)) {
+      return FETX_ERR_IO;
+    }
+    ++slot;
+  }
+  if (fprintf(fd, "$upscope $end\n$enddefinitions $end\n") < 0) {
+    return FETX_ERR_IO;
+  }
+  return FETX_ERR_NONE;
+}
+
+static void fetx_trace_free(struct fetx_trace *const trace,
+                            struct fetx_io *const io) {
+  struct fetx_node *node = io->fx.nodes;
+  while (node != io->fx.nodes_limit) {
+    node->is_traced = 0;
+    node->is_trace_listed = 0;
+    ++node;
+  }
+  fetx_dealloc(io->fx.traced_changed);
+  io->fx.traced_changed = 0;
+  io->fx.traced_changed_size = 0;
+  fetx_dealloc(trace->slots);
+  fetx_dealloc(trace->states);
+  fetx_dealloc(trace->buffers[0].data);
+  fetx_dealloc(trace->buffers[1].data);
+}
+
+/* traces the runtime nodes at the indices in \nodes, writing to \fd which
+ * stays open after the trace is closed. Each node is named after its index,
+ * or the index it maps to in \map if that is not 0. */
+
+enum fetx_errs fetx_trace_open_fd(struct fetx_trace *const trace,
+                                  struct fetx_io *const io,
+                                  const size_t *const nodes,
+                                  const size_t nodes_size, FILE *const fd,
+                                  const enum fetx_trace_formats format,
+                                  const struct fetx_netlist_map *const map) {
+  const size_t runtime_nodes_size = io->fx.nodes_limit - io->fx.nodes;
+  size_t slot = 0;
+  while (slot < nodes_size) {
+    if (nodes[slot] >= runtime_nodes_size) {
+      return FETX_ERR_PARAM;
+    }
+    ++slot;
+  }
+
+  trace->fd = fd;
+  trace->format = format;
+  trace->nodes_size = nodes_size;
+  trace->slots = fetx_alloc(sizeof(*trace->slots), runtime_nodes_size);
+  trace->states = fetx_alloc(sizeof(*trace->states), nodes_size);
+  trace->buffers[0].data = fetx_alloc(1, FETX_TRACE_BUFFER_SIZE);
+  trace->buffers[1].data = fetx_alloc(1, FETX_TRACE_BUFFER_SIZE);
+  io->fx.traced_changed =
+      fetx_alloc(sizeof(*io->fx.traced_changed), nodes_size);
+  io->fx.traced_changed_size = 0;
+  if ((trace->slots == 0) || (trace->states == 0) ||
+      (trace->buffers[0].data == 0) || (trace->buffers[1].data == 0) ||
+      (io->fx.traced_changed == 0)) {
+    fetx_trace_free(trace, io);
+    return FETX_ERR_ALLOC;
+  }
+  trace->buffers[0].size = 0;
+  trace->buffers[1].size = 0;
+  trace->fill = trace->buffers;
+  trace->write = 0;
+  trace->quit = 0;
+  trace->errs = FETX_ERR_NONE;
+
+  enum fetx_errs errs = fetx_trace_header(trace, nodes, map);
+  if (errs != FETX_ERR_NONE) {
+    fetx_trace_free(trace, io);
+    return errs;
+  }
+
+  if (pthread_mutex_init(&trace->lock, 0) != 0) {
+    fetx_trace_free(trace, io);
+    return FETX_ERR_ALLOC;
+  }
+  if (pthread_cond_init(&trace->cond, 0) != 0) {
+    pthread_mutex_destroy(&trace->lock);
+    fetx_trace_free(trace, io);
+    return FETX_ERR_ALLOC;
+  }
+  if (pthread_create(&trace->thread, 0, fetx_trace_writer, trace) != 0) {
+    pthread_cond_destroy(&trace->cond);
+    pthread_mutex_destroy(&trace->lock);
+    fetx_trace_free(trace, io);
+    return FETX_ERR_ALLOC;
+  }
+
+  /* initial values */
+  trace->time = io->time;
+  fetx_trace_put_time(trace, io->time);
+  if (format == FETX_TRACE_VCD) {
+    fetx_trace_reserve(trace);
+    const char *dumpvars = "$dumpvars\n";
+    while (*dumpvars != '\0') {
+      fetx_trace_put(trace, *dumpvars);
+      ++dumpvars;
+    }
+  }
+  slot = 0;
+  while (slot < nodes_size) {
+    struct fetx_node *const node = io->fx.nodes + nodes[slot];
+    trace->slots[nodes[slot]] = slot;
+    node->is_traced = 1;
+    fetx_trace_put_value(trace, slot, fetx_node_state_get(*node));
+    ++slot;
+  }
+  if (format == FETX_TRACE_VCD) {
+    fetx_trace_reserve(trace);
+    const char *end = "$end\n";
+    while (*end != '\0') {
+      fetx_trace_put(trace, *end);
+      ++end;
+    }
+  }
+
+  io->trace = trace;
+  return FETX_ERR_NONE;
+}
+
+enum fetx_errs fetx_trace_open(struct fetx_trace *const trace,
+                               struct fetx_io *const io,
+                               const size_t *const nodes,
+                               const size_t nodes_size,
+                               const char *const pathname,
+                               const enum fetx_trace_formats format,
+                               const struct fetx_netlist_map *const map) {
+  FILE *const fd = fopen(pathname, (format == FETX_TRACE_VCD) ? "w" : "wb");
+  if (fd == 0) {
+    return FETX_ERR_FOPEN;
+  }
+  enum fetx_errs errs =
+      fetx_trace_open_fd(trace, io, nodes, nodes_size, fd, format, map);
+  if (errs != FETX_ERR_NONE) {
+    return (fclose(fd) != 0) ? errs | FETX_ERR_FCLOSE : errs;
+  }
+  return FETX_ERR_NONE;
+}
+
+/* records the traced nodes that changed state since the last sample, called
+ * by fetx_io_resolve after each step */
+
+void fetx_trace_sample(struct fetx_trace *const trace,
+                       struct fetx_io *const io) {
+  struct fetx *const fx = &io->fx;
+  size_t i = 0;
+  while (i < fx->traced_changed_size) {
+    const size_t index = fx->traced_changed[i];
+    struct fetx_node *const node = fx->nodes + index;
+    node->is_trace_listed = 0;
+    const size_t slot = trace->slots[index];
+    const enum fetx_node_states state = fetx_node_state_get(*node);
+    if (state != trace->states[slot]) {
+      if (io->time != trace->time) {
+        fetx_trace_put_time(trace, io->time);
+      }
+      fetx_trace_put_value(trace, slot, state);
+    }
+    ++i;
+  }
+  fx->traced_changed_size = 0;
+}
+
+/* writes anything buffered and stops tracing \io, the trace must be closed
+ * before \io is deleted */
+
+enum fetx_errs fetx_trace_close_fd(struct fetx_trace *const trace,
+                                   struct fetx_io *const io) {
+  if (trace->fill->size != 0) {
+    fetx_trace_handoff(trace);
+  }
+  pthread_mutex_lock(&trace->lock);
+  trace->quit = 1;
+  pthread_cond_broadcast(&trace->cond);
+  pthread_mutex_unlock(&trace->lock);
+  pthread_join(trace->thread, 0);
+  pthread_cond_destroy(&trace->cond);
+  pthread_mutex_destroy(&trace->lock);
+
+  enum fetx_errs errs = trace->errs;
+  if (fflush(trace->fd) != 0) {
+    errs |= FETX_ERR_IO;
+  }
+  io->trace = 0;
+  fetx_trace_free(trace, io);
+  return errs;
+}
+
+enum fetx_errs fetx_trace_close(struct fetx_trace *const trace,
+                                struct fetx_io *const io) {
+  FILE *const fd = trace->fd;
+  enum fetx_errs errs = fetx_trace_close_fd(trace, io);
+  if (fclose(fd) != 0) {
+    errs |= FETX_ERR_FCLOSE;
+  }
+  return errs;
+}
@@ -0,0 +1,73 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_TRACE_H
+#define FETX_TRACE_H
+
+#include "fetx_io.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+/* records the state changes of a set of nodes, sampled after each resolve
+ * step, buffered and written out by a background thread */
+
+enum fetx_trace_formats { FETX_TRACE_VCD = 0, FETX_TRACE_BIN };
+
+struct fetx_trace_buffer {
+  unsigned char *data;
+  size_t size;
+};
+
+struct fetx_trace {
+  FILE *fd;
+  enum fetx_trace_formats format;
+  size_t *slots;     /* trace slot of each runtime node */
+  unsigned char *states; /* last state written for each slot */
+  size_t nodes_size;
+  unsigned long int time; /* time of the last record */
+  struct fetx_trace_buffer buffers[2];
+  struct fetx_trace_buffer *fill;
+  /* shared with the writer thread */
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  struct fetx_trace_buffer *write;
+  unsigned char quit;
+  enum fetx_errs errs;
+};
+
+enum fetx_errs fetx_trace_open_fd(struct fetx_trace *const trace,
+                                  struct fetx_io *const io,
+                                  const size_t *const nodes,
+                                  const size_t nodes_size, FILE *const fd,
+                                  const enum fetx_trace_formats format,
+                                  const struct fetx_netlist_map *const map);
+enum fetx_errs fetx_trace_open(struct fetx_trace *const trace,
+                               struct fetx_io *const io,
+                               const size_t *const nodes,
+                               const size_t nodes_size,
+                               const char *const pathname,
+                               const enum fetx_trace_formats format,
+                               const struct fetx_netlist_map *const map);
+void fetx_trace_sample(struct fetx_trace *const trace,
+                       struct fetx_io *const io);
+enum fetx_errs fetx_trace_close_fd(struct fetx_trace *const trace,
+                                   struct fetx_io *const io);
+enum fetx_errs fetx_trace_close(struct fetx_trace *const trace,
+                                struct fetx_io *const io);
+
+#endif
@@ -79,6 +79,178 @@ enum fetx_errs fetx_vector_split(struct fetx_vector *const sub,
   return FETX_ERR_NONE;
 }
 
+/* compares the outputs of row \t with those expected, returns -1 once the
+ * limit on mismatches is reached */
+
+static int fetx_vector_check_row(struct fetx_vector_check *const check,
+                                 const struct fetx_io *const io,
+                                 const size_t t) {
+  const enum fetx_node_states *const expected = check->expected.values[t];
+  const unsigned char *const care =
+      (check->care != 0) ? check->care[t] : 0;
+  size_t i = 0;
+  while (i < io->outputs_size) {
+    const enum fetx_node_states actual =
+        fetx_node_state_get(*io->outputs[i]);
+    if ((actual != expected[i]) && ((care == 0) || (care[i] != 0))) {
+      if (check->mismatches == 0) {
+        check->row = t;
+        check->output = i;
+        check->actual = actual;
+      }
+      ++check->mismatches;
+      if ((check->mismatches >= check->mismatches_limit) ||
+          (check->mismatches_limit == 0)) {
+        return -1;
+      }
+    }
+    ++i;
+  }
+  return 0;
+}
+
+/* resolves the changes applied to \io, each unresolved step adds the time it
+ * moved on to \time. Returns -1 once that exceeds \time_limit. */
+
+static int fetx_vector_resolve(struct fetx_io *const io,
+                               unsigned long int *const time,
+                               const unsigned long int time_limit) {
+  unsigned long int now = io->time;
+  while (fetx_io_resolve(io) == 0) {
+    *time += io->time - now;
+    now = io->time;
+    if ((time_limit != 0) && (*time > time_limit)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* runs \length rows, from \stim if it isn't 0, into \output_vector, or checks
+ * them with \check if it isn't 0. Outputs are dropped when neither has
+ * values. */
+
+static enum fetx_errs fetx_vector_run(struct fetx_sim_res *const res,
+                                      struct fetx_vector output_vector,
+                                      struct fetx_vector_check *const check,
+                                      struct fetx_io *const io,
+                                      const struct fetx_vector input_vector,
+                                      struct fetx_stim *const stim,
+                                      const size_t length,
+                                      const unsigned long int time_limit) {
+  unsigned long int time = 0;
+  unsigned long int multiply_driven = 0;
+
+  size_t t = 0;
+  while (t < length) {
+    const enum fetx_node_states *const row =
+        (stim != 0) ? fetx_stim_next(stim) : input_vector.values[t];
+    const size_t changed = fetx_io_inputs_apply(io, row);
+    const enum fetx_errs errs = fetx_io_errs(io);
+    if (errs != FETX_ERR_NONE) {
+      res->multiply_driven = multiply_driven;
+      res->time = time;
+      return errs;
+    }
+    /* an unchanged row on a resolved circuit has the previous outputs */
+    if ((changed == 0) && (t != 0)) {
+      multiply_driven += fetx_multiple_drive_count(&io->fx);
+      if (check != 0) {
+        if (fetx_vector_check_row(check, io, t) != 0) {
+          break;
+        }
+      } else if (output_vector.values != 0) {
+        size_t i = 0;
+        while (i < output_vector.width) {
+          output_vector.values[t][i] = output_vector.values[t - 1][i];
+          ++i;
+        }
+      }
+      ++t;
+      continue;
+    }
+
+    if (fetx_vector_resolve(io, &time, time_limit) != 0) {
+      res->multiply_driven = multiply_driven;
+      res->time = time;
+      return FETX_ERR_TIMEOUT;
+    }
+
+    multiply_driven += fetx_multiple_drive_count(&io->fx);
+
+    if (check != 0) {
+      if (fetx_vector_check_row(check, io, t) != 0) {
+        break;
+      }
+    } else if (output_vector.values != 0) {
+      fetx_io_outputs(output_vector.values[t], *io);
+    }
+    ++t;
+  }
+
+  res->multiply_driven = multiply_driven;
+  res->time = time;
+  return ((check != 0) && (check->mismatches != 0)) ? FETX_ERR_MISMATCH
+                                                     : FETX_ERR_NONE;
+}
+
+/* simulates on an initialised runtime, \io is left in its final state */
+
+enum fetx_errs fetx_vector_sim_io(struct fetx_sim_res *const res,
+                                  struct fetx_vector output_vector,
+                                  struct fetx_io *const io,
+                                  const struct fetx_vector input_vector,
+                                  const unsigned long int time_limit) {
+  if ((input_vector.length != output_vector.length) ||
+      (input_vector.width != io->inputs_size) ||
+      (output_vector.width != io->outputs_size)) {
+    return FETX_ERR_PARAM;
+  }
+  return fetx_vector_run(res, output_vector, 0, io, input_vector, 0,
+                         input_vector.length, time_limit);
+}
+
+/* as fetx_vector_sim_io, comparing each row with those expected by \check as
+ * it resolves rather than keeping the outputs. Stops at the row the limit on
+ * mismatches is reached in, \io is left in the state it stopped in. */
+
+enum fetx_errs fetx_vector_check_io(struct fetx_sim_res *const res,
+                                    struct fetx_vector_check *const check,
+                                    struct fetx_io *const io,
+                                    const struct fetx_vector input_vector,
+                                    const unsigned long int time_limit) {
+  if ((input_vector.length != check->expected.length) ||
+      (input_vector.width != io->inputs_size) ||
+      (check->expected.width != io->outputs_size)) {
+    return FETX_ERR_PARAM;
+  }
+  check->mismatches = 0;
+  return fetx_vector_run(res, (struct fetx_vector){.values = 0}, check, io,
+                         input_vector, 0, input_vector.length, time_limit);
+}
+
+enum fetx_errs fetx_vector_check(struct fetx_sim_res *const res,
+                                 struct fetx_vector_check *const check,
+                                 const struct fetx_netlist nl,
+                                 const struct fetx_vector input_vector,
+                                 const unsigned long int time_limit) {
+  if ((input_vector.length != check->expected.length) ||
+      (input_vector.width != nl.inputs_size) ||
+      (check->expected.width != nl.outputs_size)) {
+    return FETX_ERR_PARAM;
+  }
+
+  struct fetx_io io;
+  if (fetx_io_init(&io, nl) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+
+  const enum fetx_errs errs =
+      fetx_vector_check_io(res, check, &io, input_vector, time_limit);
+  fetx_io_delete(io);
+  return errs;
+}
+
 enum fetx_errs fetx_vector_sim(struct fetx_sim_res *const res,
                                struct fetx_vector output_vector,
                                const struct fetx_netlist nl,
@@ -95,34 +267,186 @@ enum fetx_errs fetx_vector_sim(struct fetx_sim_res *const res,
     return FETX_ERR_ALLOC;
   }
 
-  unsigned long int time = 0;
-  unsigned long int multiply_driven = 0;
+  const enum fetx_errs errs =
+      fetx_vector_sim_io(res, output_vector, &io, input_vector, time_limit);
+  fetx_io_delete(io);
+  return errs;
+}
 
-  size_t t = 0;
-  while (t < input_vector.length) {
-    fetx_io_inputs(&io, input_vector.values[t]);
+/* as fetx_vector_sim_io, taking \rows rows from \stim in place of an input
+ * vector. \output_vector may have no values when only the result is wanted,
+ * otherwise it must be \rows long. */
+
+enum fetx_errs fetx_vector_sim_stim_io(struct fetx_sim_res *const res,
+                                       struct fetx_vector output_vector,
+                                       struct fetx_io *const io,
+                                       struct fetx_stim *const stim,
+                                       const size_t rows,
+                                       const unsigned long int time_limit) {
+  if ((stim->width != io->inputs_size) ||
+      ((output_vector.values != 0) &&
+       ((output_vector.length != rows) ||
+        (output_vector.width != io->outputs_size)))) {
+    return FETX_ERR_PARAM;
+  }
+  return fetx_vector_run(res, output_vector, 0, io,
+                         (struct fetx_vector){.values = 0}, stim, rows,
+                         time_limit);
+}
 
-    while (fetx_io_resolve(&io) == 0) {
-      ++time;
-      if ((time_limit != 0) && (time > time_limit)) {
-        fetx_io_delete(io);
-        res->multiply_driven = multiply_driven;
-        res->time = time;
-        return FETX_ERR_TIMEOUT;
-      }
+enum fetx_errs fetx_vector_sim_stim(struct fetx_sim_res *const res,
+                                    struct fetx_vector output_vector,
+                                    const struct fetx_netlist nl,
+                                    struct fetx_stim *const stim,
+                                    const size_t rows,
+                                    const unsigned long int time_limit) {
+  if ((stim->width != nl.inputs_size) ||
+      ((output_vector.values != 0) &&
+       ((output_vector.length != rows) ||
+        (output_vector.width != nl.outputs_size)))) {
+    return FETX_ERR_PARAM;
+  }
+
+  struct fetx_io io;
+  if (fetx_io_init(&io, nl) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+
+  const enum fetx_errs errs =
+      fetx_vector_sim_stim_io(res, output_vector, &io, stim, rows, time_limit);
+  fetx_io_delete(io);
+  return errs;
+}
+
+/* the number of phases of \clocks the outputs are kept after, 0 if the
+ * clocks don't fit \inputs_size inputs */
+
+static size_t fetx_vector_clocks_samples(const struct fetx_vector_clocks clocks,
+                                         const size_t inputs_size) {
+  if ((clocks.phases.length == 0) ||
+      (clocks.phases.width != clocks.inputs_size)) {
+    return 0;
+  }
+  size_t i = 0;
+  while (i < clocks.inputs_size) {
+    if (clocks.inputs[i] >= inputs_size) {
+      return 0;
     }
+    ++i;
+  }
+  if (clocks.sample == 0) {
+    return 1;
+  }
+  size_t samples = 0;
+  i = 0;
+  while (i < clocks.phases.length) {
+    samples += (clocks.sample[i] != 0);
+    ++i;
+  }
+  return samples;
+}
 
-    multiply_driven += fetx_multiple_drive_detect(io.fx);
+/* as fetx_vector_sim_io, with each row of \input_vector applied once for each
+ * phase of \clocks, which drive their inputs in place of the columns of the
+ * row. A row of \output_vector is kept for each sampled phase. Phases that
+ * change no input leave the circuit as it was and are not resolved. */
+
+enum fetx_errs fetx_vector_sim_clocked_io(
+    struct fetx_sim_res *const res, struct fetx_vector output_vector,
+    struct fetx_io *const io, const struct fetx_vector_clocks clocks,
+    const struct fetx_vector input_vector, const unsigned long int time_limit) {
+  const size_t samples = fetx_vector_clocks_samples(clocks, io->inputs_size);
+  size_t outputs_length;
+  if ((samples == 0) ||
+      fetx_check_multiply(&outputs_length, input_vector.length, samples) ||
+      (input_vector.width != io->inputs_size) ||
+      (output_vector.length != outputs_length) ||
+      (output_vector.width != io->outputs_size)) {
+    return FETX_ERR_PARAM;
+  }
+  /* the clock driving each input, plus 1, or 0 */
+  size_t *const clock_of = fetx_calloc(io->inputs_size + 1, sizeof(size_t));
+  if (clock_of == 0) {
+    return FETX_ERR_ALLOC;
+  }
+  size_t i = 0;
+  while (i < clocks.inputs_size) {
+    clock_of[clocks.inputs[i]] = i + 1;
+    ++i;
+  }
 
-    fetx_io_outputs(output_vector.values[t], io);
+  enum fetx_errs errs = FETX_ERR_NONE;
+  unsigned long int time = 0;
+  unsigned long int multiply_driven = 0;
+  size_t sample = 0;
+  size_t t = 0;
+  while ((errs == FETX_ERR_NONE) && (t < input_vector.length)) {
+    size_t phase = 0;
+    while (phase < clocks.phases.length) {
+      const enum fetx_node_states *const states = clocks.phases.values[phase];
+      size_t changed = 0;
+      if (phase == 0) {
+        /* a new row, the rest of the phases only move the clocks */
+        changed = fetx_io_supplies_list(io);
+        i = 0;
+        while (i < io->inputs_size) {
+          changed += fetx_io_input_list(
+              io, i,
+              (clock_of[i] != 0) ? states[clock_of[i] - 1]
+                                 : input_vector.values[t][i]);
+          ++i;
+        }
+      } else {
+        i = 0;
+        while (i < clocks.inputs_size) {
+          changed += fetx_io_input_list(io, clocks.inputs[i], states[i]);
+          ++i;
+        }
+      }
+      errs = fetx_io_errs(io);
+      if (errs != FETX_ERR_NONE) {
+        break;
+      }
+      if ((changed != 0) || ((t == 0) && (phase == 0))) {
+        if (changed != 0) {
+          fetx_input_nodes_update(&io->fx);
+        }
+        if (fetx_vector_resolve(io, &time, time_limit) != 0) {
+          errs = FETX_ERR_TIMEOUT;
+          break;
+        }
+      }
+      multiply_driven += fetx_multiple_drive_count(&io->fx);
+      if ((clocks.sample != 0) ? (clocks.sample[phase] != 0)
+                               : (phase == (clocks.phases.length - 1))) {
+        fetx_io_outputs(output_vector.values[sample], *io);
+        ++sample;
+      }
+      ++phase;
+    }
     ++t;
   }
-
+  fetx_dealloc(clock_of);
   res->multiply_driven = multiply_driven;
   res->time = time;
+  return errs;
+}
 
+enum fetx_errs fetx_vector_sim_clocked(struct fetx_sim_res *const res,
+                                       struct fetx_vector output_vector,
+                                       const struct fetx_netlist nl,
+                                       const struct fetx_vector_clocks clocks,
+                                       const struct fetx_vector input_vector,
+                                       const unsigned long int time_limit) {
+  struct fetx_io io;
+  if (fetx_io_init(&io, nl) != 0) {
+    return FETX_ERR_ALLOC;
+  }
+
+  const enum fetx_errs errs = fetx_vector_sim_clocked_io(
+      res, output_vector, &io, clocks, input_vector, time_limit);
   fetx_io_delete(io);
-  return FETX_ERR_NONE;
+  return errs;
 }
 
 static int fetx_vector_file_stride_eol(struct fetx_vector *const v,
@@ -18,6 +18,7 @@ limitations under the License.
 #define FETX_VECTOR_H
 
 #include "fetx_io.h"
+#include "fetx_stim.h"
 
 struct fetx_vector {
   enum fetx_node_states **values;
@@ -30,18 +31,86 @@ struct fetx_sim_res {
   unsigned long int time;
 };
 
+/* outputs to check each row against as soon as it resolves, in place of an
+ * output vector */
+
+struct fetx_vector_check {
+  struct fetx_vector expected;
+  /* 0 to check every output, otherwise 0 in care[row][output] accepts any
+   * state there */
+  const unsigned char *const *care;
+  size_t mismatches_limit; /* stop after this many, 0 stops at the first */
+  /* results */
+  size_t mismatches;
+  size_t row; /* of the first mismatch */
+  size_t output;
+  enum fetx_node_states actual;
+};
+
+/* clock inputs driven through a pattern of phases for each input row */
+
+struct fetx_vector_clocks {
+  const size_t *inputs; /* input index of each clock */
+  size_t inputs_size;
+  /* a row of a state for each clock per phase */
+  struct fetx_vector phases;
+  /* 0 in sample[phase] doesn't keep the outputs after it, 0 keeps them
+   * after the last phase only */
+  const unsigned char *sample;
+};
+
 void fetx_vector_delete(struct fetx_vector v);
 enum fetx_errs fetx_vector_new(struct fetx_vector *const v);
 enum fetx_errs fetx_vector_split(struct fetx_vector *const sub,
                                  const struct fetx_vector v,
                                  const size_t start);
 
+enum fetx_errs fetx_vector_sim_io(struct fetx_sim_res *const res,
+                                  struct fetx_vector output_vector,
+                                  struct fetx_io *const io,
+                                  const struct fetx_vector input_vector,
+                                  const unsigned long int time_limit);
 enum fetx_errs fetx_vector_sim(struct fetx_sim_res *const res,
                                struct fetx_vector output_vector,
                                const struct fetx_netlist nl,
                                const struct fetx_vector input_vector,
                                const unsigned long int time_limit);
 
+enum fetx_errs fetx_vector_sim_stim_io(struct fetx_sim_res *const res,
+                                       struct fetx_vector output_vector,
+                                       struct fetx_io *const io,
+                                       struct fetx_stim *const stim,
+                                       const size_t rows,
+                                       const unsigned long int time_limit);
+enum fetx_errs fetx_vector_sim_stim(struct fetx_sim_res *const res,
+                                    struct fetx_vector output_vector,
+                                    const struct fetx_netlist nl,
+                                    struct fetx_stim *const stim,
+                                    const size_t rows,
+                                    const unsigned long int time_limit);
+
+enum fetx_errs fetx_vector_sim_clocked_io(
+    struct fetx_sim_res *const res, struct fetx_vector output_vector,
+    struct fetx_io *const io, const struct fetx_vector_clocks clocks,
+    const struct fetx_vector input_vector, const unsigned long int time_limit);
+enum fetx_errs fetx_vector_sim_clocked(struct fetx_sim_res *const res,
+                                       struct fetx_vector output_vector,
+                                       const struct fetx_netlist nl,
+                                       const struct fetx_vector_clocks clocks,
+                                       const struct fetx_vector input_vector,
+                                       const unsigned long int time_limit);
+
+enum fetx_errs fetx_vector_check_io(struct fetx_sim_res *const res,
+                                    struct fetx_vector_check *const check,
+                                    struct fetx_io *const io,
+                                    const struct fetx_vector input_vector,
+                                    const unsigned long int time_limit);
+enum fetx_errs fetx_vector_check(struct fetx_sim_res *const res,
+                                 struct fetx_vector_check *const check,
+                                 const struct fetx_netlist nl,
+                                 const struct fetx_vector input_vector,
+                                 const unsigned long int time_limit);
+
 enum fetx_errs fetx_vector_from_file(struct fetx_vector *const v,
                                      const char *const pathname);
 enum fetx_errs fetx_vector_to_file(struct fetx_vector v,
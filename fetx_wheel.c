@@ -0,0 +1,256 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "fetx_wheel.h"
+#include "fetx.h"
+
+#define FETX_WHEEL_OVERFLOW (FETX_WHEEL_LEVELS * FETX_WHEEL_SLOTS)
+#define FETX_WHEEL_IDLE (FETX_WHEEL_OVERFLOW + 1)
+
+static unsigned int fetx_wheel_lowest(const unsigned long long int bits) {
+#ifdef __GNUC__
+  return (unsigned int)__builtin_ctzll(bits);
+#else
+  unsigned int i = 0;
+  while (((bits >> i) & 1) == 0) {
+    ++i;
+  }
+  return i;
+#endif
+}
+
+void fetx_wheel_delete(struct fetx_wheel *const wheel) {
+  if (wheel != 0) {
+    fetx_dealloc(wheel->entries);
+    fetx_dealloc(wheel);
+  }
+}
+
+/* an empty wheel for items 0 up to \entries_size, taking times from \now */
+
+struct fetx_wheel *fetx_wheel_new(const size_t entries_size,
+                                  const unsigned long long int now) {
+  struct fetx_wheel *const wheel = fetx_alloc(sizeof(*wheel), 1);
+  if (wheel == 0) {
+    return 0;
+  }
+  wheel->entries = fetx_alloc(sizeof(*wheel->entries), entries_size);
+  if ((wheel->entries == 0) && (entries_size != 0)) {
+    fetx_dealloc(wheel);
+    return 0;
+  }
+  wheel->entries_size = entries_size;
+  size_t i = 0;
+  while (i < entries_size) {
+    wheel->entries[i].slot = FETX_WHEEL_IDLE;
+    ++i;
+  }
+  i = 0;
+  while (i <= FETX_WHEEL_OVERFLOW) {
+    wheel->heads[i] = FETX_WHEEL_NONE;
+    wheel->tails[i] = FETX_WHEEL_NONE;
+    ++i;
+  }
+  i = 0;
+  while (i < FETX_WHEEL_LEVELS) {
+    wheel->occupied[i] = 0;
+    ++i;
+  }
+  wheel->now = now;
+  wheel->size = 0;
+  return wheel;
+}
+
+int fetx_wheel_is_scheduled(const struct fetx_wheel *const wheel,
+                            const size_t item) {
+  return wheel->entries[item].slot != FETX_WHEEL_IDLE;
+}
+
+void fetx_wheel_remove(struct fetx_wheel *const wheel, const size_t item) {
+  struct fetx_wheel_entry *const entry = wheel->entries + item;
+  if (entry->slot == FETX_WHEEL_IDLE) {
+    return;
+  }
+  if (entry->next != FETX_WHEEL_NONE) {
+    wheel->entries[entry->next].prev = entry->prev;
+  } else {
+    wheel->tails[entry->slot] = entry->prev;
+  }
+  if (entry->prev != FETX_WHEEL_NONE) {
+    wheel->entries[entry->prev].next = entry->next;
+  } else {
+    wheel->heads[entry->slot] = entry->next;
+    if ((entry->next == FETX_WHEEL_NONE) &&
+        (entry->slot < FETX_WHEEL_OVERFLOW)) {
+      wheel->occupied[entry->slot / FETX_WHEEL_SLOTS] &=
+          ~(1ull << (entry->slot % FETX_WHEEL_SLOTS));
+    }
+  }
+  entry->slot = FETX_WHEEL_IDLE;
+  --wheel->size;
+}
+
+/* schedules \item at \time, which must not be before wheel->now, moving it
+ * if it was already scheduled. The level is that of the highest bit the time
+ * differs from now in, so the slot is in the same block as now. */
+
+void fetx_wheel_insert(struct fetx_wheel *const wheel, const size_t item,
+                       const unsigned long long int time) {
+  fetx_wheel_remove(wheel, item);
+  const unsigned long long int diff = time ^ wheel->now;
+  unsigned int level = 0;
+  while ((level < FETX_WHEEL_LEVELS) &&
+         ((diff >> (FETX_WHEEL_BITS * (level + 1))) != 0)) {
+    ++level;
+  }
+  unsigned int slot = FETX_WHEEL_OVERFLOW;
+  if (level < FETX_WHEEL_LEVELS) {
+    const unsigned int s =
+        (unsigned int)(time >> (FETX_WHEEL_BITS * level)) &
+        (FETX_WHEEL_SLOTS - 1);
+    slot = (level * FETX_WHEEL_SLOTS) + s;
+    wheel->occupied[level] |= 1ull << s;
+  }
+  struct fetx_wheel_entry *const entry = wheel->entries + item;
+  entry->time = time;
+  entry->slot = slot;
+  entry->prev = wheel->tails[slot];
+  entry->next = FETX_WHEEL_NONE;
+  if (entry->prev != FETX_WHEEL_NONE) {
+    wheel->entries[entry->prev].next = item;
+  } else {
+    wheel->heads[slot] = item;
+  }
+  wheel->tails[slot] = item;
+  ++wheel->size;
+}
+
+/* moves the items of a slot to the slots now puts them in, in order */
+
+static void fetx_wheel_cascade(struct fetx_wheel *const wheel,
+                               const unsigned int slot) {
+  size_t item = wheel->heads[slot];
+  wheel->heads[slot] = FETX_WHEEL_NONE;
+  wheel->tails[slot] = FETX_WHEEL_NONE;
+  if (slot < FETX_WHEEL_OVERFLOW) {
+    wheel->occupied[slot / FETX_WHEEL_SLOTS] &=
+        ~(1ull << (slot % FETX_WHEEL_SLOTS));
+  }
+  while (item != FETX_WHEEL_NONE) {
+    struct fetx_wheel_entry *const entry = wheel->entries + item;
+    const size_t next = entry->next;
+    entry->slot = FETX_WHEEL_IDLE;
+    --wheel->size;
+    fetx_wheel_insert(wheel, item, entry->time);
+    item = next;
+  }
+}
+
+/* moves the items in the blocks now is in down to level 0 */
+
+static void fetx_wheel_spread(struct fetx_wheel *const wheel) {
+  unsigned int level = FETX_WHEEL_LEVELS;
+  while (level > 1) {
+    --level;
+    const unsigned int s =
+        (unsigned int)(wheel->now >> (FETX_WHEEL_BITS * level)) &
+        (FETX_WHEEL_SLOTS - 1);
+    if ((wheel->occupied[level] & (1ull << s)) != 0) {
+      fetx_wheel_cascade(wheel, (level * FETX_WHEEL_SLOTS) + s);
+    }
+  }
+}
+
+/* finds the earliest scheduled time, now may move up to it. Returns 0 if
+ * nothing is scheduled. */
+
+int fetx_wheel_next(struct fetx_wheel *const wheel,
+                    unsigned long long int *const time) {
+  while (wheel->size != 0) {
+    fetx_wheel_spread(wheel);
+    const unsigned int now_slot =
+        (unsigned int)wheel->now & (FETX_WHEEL_SLOTS - 1);
+    const unsigned long long int due =
+        wheel->occupied[0] & (~0ull << now_slot);
+    if (due != 0) {
+      *time = (wheel->now & ~(unsigned long long int)(FETX_WHEEL_SLOTS - 1)) |
+              fetx_wheel_lowest(due);
+      return 1;
+    }
+
+    /* now moves to the start of the next occupied slot of the lowest level
+     * that has one, which is spread down on the next pass */
+    unsigned int level = 1;
+    while (level < FETX_WHEEL_LEVELS) {
+      const unsigned int shift = FETX_WHEEL_BITS * level;
+      const unsigned int s =
+          (unsigned int)(wheel->now >> shift) & (FETX_WHEEL_SLOTS - 1);
+      const unsigned long long int later =
+          (s == (FETX_WHEEL_SLOTS - 1))
+              ? 0
+              : (wheel->occupied[level] & (~0ull << (s + 1)));
+      if (later != 0) {
+        wheel->now = ((wheel->now >> (shift + FETX_WHEEL_BITS))
+                      << (shift + FETX_WHEEL_BITS)) |
+                     ((unsigned long long int)fetx_wheel_lowest(later)
+                      << shift);
+        break;
+      }
+      ++level;
+    }
+    if (level == FETX_WHEEL_LEVELS) {
+      /* only the overflow is left, now moves to its earliest */
+      size_t item = wheel->heads[FETX_WHEEL_OVERFLOW];
+      unsigned long long int earliest = wheel->entries[item].time;
+      while (item != FETX_WHEEL_NONE) {
+        if (wheel->entries[item].time < earliest) {
+          earliest = wheel->entries[item].time;
+        }
+        item = wheel->entries[item].next;
+      }
+      wheel->now = earliest;
+      fetx_wheel_cascade(wheel, FETX_WHEEL_OVERFLOW);
+    }
+  }
+  return 0;
+}
+
+/* takes the items scheduled at \time, nothing may be scheduled before it,
+ * and returns the first, the rest follow through entries[].next in the order
+ * they were scheduled in. Times up to \time can no longer be scheduled.
+ * Returns FETX_WHEEL_NONE if nothing is scheduled at \time. */
+
+size_t fetx_wheel_take(struct fetx_wheel *const wheel,
+                       const unsigned long long int time) {
+  wheel->now = time;
+  fetx_wheel_spread(wheel);
+  const unsigned int s = (unsigned int)time & (FETX_WHEEL_SLOTS - 1);
+  size_t first = FETX_WHEEL_NONE;
+  if ((wheel->occupied[0] & (1ull << s)) != 0) {
+    first = wheel->heads[s];
+    wheel->heads[s] = FETX_WHEEL_NONE;
+    wheel->tails[s] = FETX_WHEEL_NONE;
+    wheel->occupied[0] &= ~(1ull << s);
+    size_t item = first;
+    while (item != FETX_WHEEL_NONE) {
+      wheel->entries[item].slot = FETX_WHEEL_IDLE;
+      --wheel->size;
+      item = wheel->entries[item].next;
+    }
+  }
+  wheel->now = time + 1;
+  return first;
+}
@@ -0,0 +1,65 @@
+/*
+Copyright 2017 Julian Ingram
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FETX_WHEEL_H
+#define FETX_WHEEL_H
+
+#include <stddef.h>
+
+/* a hierarchical timing wheel of items scheduled at integer times. Level l
+ * has a slot per 64^l time units over the next 64^(l + 1), items further
+ * ahead than the top level wait on an overflow list. Scheduling and removal
+ * are O(1), and finding the next time skips empty slots a level at a time
+ * with a bit per slot. */
+
+#define FETX_WHEEL_BITS 6
+#define FETX_WHEEL_SLOTS (1u << FETX_WHEEL_BITS)
+#define FETX_WHEEL_LEVELS 4
+#define FETX_WHEEL_NONE ((size_t)-1)
+
+struct fetx_wheel_entry {
+  unsigned long long int time;
+  size_t next;
+  size_t prev;
+  unsigned int slot; /* list the entry is on, or past the overflow if none */
+};
+
+struct fetx_wheel {
+  struct fetx_wheel_entry *entries; /* per item */
+  size_t entries_size;
+  /* list heads and tails per slot of each level, then the overflow list,
+   * items are appended so each list is in the order they were scheduled */
+  size_t heads[(FETX_WHEEL_LEVELS * FETX_WHEEL_SLOTS) + 1];
+  size_t tails[(FETX_WHEEL_LEVELS * FETX_WHEEL_SLOTS) + 1];
+  unsigned long long int occupied[FETX_WHEEL_LEVELS]; /* bit per slot */
+  unsigned long long int now; /* earliest time not yet taken */
+  size_t size;                /* items scheduled */
+};
+
+void fetx_wheel_delete(struct fetx_wheel *const wheel);
+struct fetx_wheel *fetx_wheel_new(const size_t entries_size,
+                                  const unsigned long long int now);
+int fetx_wheel_is_scheduled(const struct fetx_wheel *const wheel,
+                            const size_t item);
+void fetx_wheel_remove(struct fetx_wheel *const wheel, const size_t item);
+void fetx_wheel_insert(struct fetx_wheel *const wheel, const size_t item,
+                       const unsigned long long int time);
+int fetx_wheel_next(struct fetx_wheel *const wheel,
+                    unsigned long long int *const time);
+size_t fetx_wheel_take(struct fetx_wheel *const wheel,
+                       const unsigned long long int time);
+
+#endif
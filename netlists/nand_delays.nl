@@ -0,0 +1,8 @@
+i 0 1 2 3
+o 4
+p 2 1 4
+p 3 1 4
+n 2 4 5
+n 3 5 0
+t 4 3
+d 3 7
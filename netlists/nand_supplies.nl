@@ -0,0 +1,8 @@
+i 2 3
+o 4
+g 0
+v 1
+p 2 1 4
+p 3 1 4
+n 2 4 5
+n 3 5 0
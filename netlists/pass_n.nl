@@ -0,0 +1,6 @@
+i 2
+o 3 5
+g 0
+v 1
+n 1 2 3
+n 1 1 5
@@ -0,0 +1,6 @@
+i 2
+o 3 5
+g 0
+v 1
+p 0 2 3
+p 0 0 5
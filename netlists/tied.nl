@@ -0,0 +1,10 @@
+i 2
+o 4
+g 0
+v 1
+p 0 1 6
+n 0 6 0
+p 2 1 4
+p 6 1 4
+n 2 4 5
+n 6 5 0
@@ -0,0 +1,302 @@
+i 0 1 2
+o 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+p 2 1 3
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
+n 2 3 0
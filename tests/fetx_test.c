@@ -14,10 +14,20 @@ See the License for the specific language governing permissions and
 limitations under the License.
  */
 
+#include "../fetx_batch.h"
+#include "../fetx_cache.h"
+#include "../fetx_farm.h"
+#include "../fetx_handle.h"
+#include "../fetx_trace.h"
 #include "../fetx_vector.h"
 
+#include <dirent.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 
 int vector_compare(const struct fetx_vector a, const struct fetx_vector b) {
   if ((a.length != b.length) || (a.width != b.width)) {
@@ -37,6 +47,1251 @@ int vector_compare(const struct fetx_vector a, const struct fetx_vector b) {
   return 0;
 }
 
+/* checks the multiply driven nodes kept by the runtime against its states */
+
+int fetx_test_multiple_nodes(const struct fetx_io io) {
+  const size_t *nodes;
+  const size_t size = fetx_multiple_drive_nodes(&io.fx, &nodes);
+  size_t count = 0;
+  const struct fetx_node *node = io.fx.nodes;
+  while (node != io.fx.nodes_limit) {
+    if (fetx_node_state_get(*node) == FETX_UNSTABLE_MULTIPLE) {
+      ++count;
+    }
+    ++node;
+  }
+  if (count != size) {
+    return -1;
+  }
+  size_t i = 0;
+  while (i < size) {
+    if (fetx_node_state_get(io.fx.nodes[nodes[i]]) != FETX_UNSTABLE_MULTIPLE) {
+      return -1;
+    }
+    ++i;
+  }
+  return 0;
+}
+
+static int fetx_test_read_varint(FILE *const fd,
+                                 unsigned long long int *const value) {
+  unsigned char shift = 0;
+  *value = 0;
+  while (1) {
+    const int c = fgetc(fd);
+    if (c == EOF) {
+      return -1;
+    }
+    *value |= (unsigned long long int)(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      return 0;
+    }
+    shift += 7;
+  }
+}
+
+/* reads the last state recorded for each node back from a trace, VCD values
+ * are read as their characters */
+
+int fetx_test_trace_read(unsigned char *const states, const size_t size,
+                         FILE *const fd,
+                         const enum fetx_trace_formats format) {
+  if (format == FETX_TRACE_BIN) {
+    unsigned long long int value;
+    size_t i = 0;
+    while (i < 8) {
+      if (fgetc(fd) == EOF) {
+        return -1;
+      }
+      ++i;
+    }
+    if ((fetx_test_read_varint(fd, &value) != 0) || (value != size)) {
+      return -1;
+    }
+    i = 0;
+    while (i < size) {
+      if (fetx_test_read_varint(fd, &value) != 0) {
+        return -1;
+      }
+      ++i;
+    }
+    while (fetx_test_read_varint(fd, &value) == 0) {
+      if ((value & 7) != 7) {
+        if ((value >> 3) >= size) {
+          return -1;
+        }
+        states[value >> 3] = value & 7;
+      }
+    }
+    return 0;
+  }
+
+  char line[256];
+  unsigned char defined = 0;
+  while (fgets(line, sizeof(line), fd) != 0) {
+    if (defined == 0) {
+      if (line[0] == '$' && line[1] == 'e' && line[4] == 'd' &&
+          line[5] == 'e') { /* $enddefinitions */
+        defined = 1;
+      }
+    } else if ((line[0] != '#') && (line[0] != '$')) {
+      size_t slot = 0;
+      size_t scale = 1;
+      const char *c = line + 1;
+      while ((*c != '\n') && (*c != '\0')) {
+        slot += (*c - '!') * scale;
+        scale *= 94;
+        ++c;
+      }
+      if (slot >= size) {
+        return -1;
+      }
+      states[slot] = line[0];
+    }
+  }
+  return (defined != 0) ? 0 : -1;
+}
+
+/* a netlist with its vector and the results of the reference run, which
+ * every other way of simulating it is checked against */
+
+struct fetx_test_case {
+  struct fetx_netlist nl;
+  struct fetx_vector input_vec;
+  struct fetx_vector correct_vec;
+  struct fetx_sim_res correct_res;
+  unsigned long int time_limit;
+};
+
+/* how the results of a run are checked against its case */
+
+struct fetx_test_opts {
+  const char *name;
+  struct fetx_io_opts io_opts;
+  unsigned int check_time : 1;     /* the time must match */
+  unsigned int check_time_max : 1; /* the time must not be longer */
+};
+
+static int fetx_test_outputs_new(struct fetx_vector *const output_vec,
+                                 const struct fetx_test_case *const tc) {
+  output_vec->width = tc->correct_vec.width;
+  output_vec->length = tc->correct_vec.length;
+  return (fetx_vector_new(output_vec) == FETX_ERR_NONE) ? 0 : -1;
+}
+
+/* checks the results of a run of \tc, printing what differs */
+
+static int fetx_test_results(const struct fetx_test_case *const tc,
+                             const struct fetx_test_opts *const opts,
+                             const enum fetx_errs errs,
+                             const struct fetx_sim_res res,
+                             const struct fetx_vector output_vec) {
+  if (errs != FETX_ERR_NONE) {
+    printf("Simulation failed (%s): %u\n", opts->name, errs);
+    return -1;
+  }
+
+  if ((res.multiply_driven != tc->correct_res.multiply_driven) ||
+      ((opts->check_time != 0) && (res.time != tc->correct_res.time)) ||
+      ((opts->check_time_max != 0) && (res.time > tc->correct_res.time))) {
+    printf("Simulation failed (%s): %lu multiply driven, time %lu, expected "
+           "%lu, time %lu\n",
+           opts->name, res.multiply_driven, res.time,
+           tc->correct_res.multiply_driven, tc->correct_res.time);
+    return -1;
+  }
+
+  if (vector_compare(output_vec, tc->correct_vec) != 0) {
+    puts("Expected:");
+    fetx_vector_print(tc->correct_vec);
+    puts("Actual:");
+    fetx_vector_print(output_vec);
+    printf("Simulation failed (%s): Actual outputs do not match expected "
+           "outputs\n",
+           opts->name);
+    return -1;
+  }
+  return 0;
+}
+
+/* simulates \tc on an initialised runtime and checks the results, \io is left
+ * in its final state */
+
+static int fetx_test_run_io(const struct fetx_test_case *const tc,
+                            const struct fetx_test_opts *const opts,
+                            struct fetx_io *const io) {
+  struct fetx_vector output_vec;
+  if (fetx_test_outputs_new(&output_vec, tc) != 0) {
+    return -1;
+  }
+  struct fetx_sim_res res;
+  const enum fetx_errs errs = fetx_vector_sim_io(
+      &res, output_vec, io, tc->input_vec, tc->time_limit);
+  int ret = fetx_test_results(tc, opts, errs, res, output_vec);
+  if ((ret == 0) && (fetx_test_multiple_nodes(*io) != 0)) {
+    printf("Simulation failed (%s): multiply driven nodes not kept\n",
+           opts->name);
+    ret = -1;
+  }
+  fetx_vector_delete(output_vec);
+  return ret;
+}
+
+/* simulates \tc on a runtime built with \opts */
+
+int fetx_test_variant(const struct fetx_test_case *const tc,
+                      const struct fetx_test_opts *const opts) {
+  struct fetx_io io;
+  if (fetx_io_init_opts(&io, tc->nl, opts->io_opts) != 0) {
+    printf("Simulation failed (%s): could not initialise\n", opts->name);
+    return -1;
+  }
+  const int ret = fetx_test_run_io(tc, opts, &io);
+  fetx_io_delete(io);
+  return ret;
+}
+
+/* a copy of \nl without its first \skip inputs, with room for \extra more
+ * supplies after its own */
+
+static int fetx_test_netlist_copy(struct fetx_netlist *const copy,
+                                  const struct fetx_netlist nl,
+                                  const size_t skip, const size_t extra) {
+  copy->fl.size = nl.fl.size;
+  copy->inputs_size = nl.inputs_size - skip;
+  copy->outputs_size = nl.outputs_size;
+  copy->supplies_size = nl.supplies_size + extra;
+  copy->nodes_size = nl.nodes_size;
+  if (fetx_netlist_new(copy) != FETX_ERR_NONE) {
+    fetx_netlist_delete(*copy);
+    return -1;
+  }
+  size_t i = 0;
+  while (i < nl.fl.size) {
+    fetx_netlist_assign_fet(copy, nl.fl.fets[i], i);
+    ++i;
+  }
+  i = 0;
+  while (i < copy->inputs_size) {
+    fetx_netlist_assign_input(copy, nl.inputs[i + skip], i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.outputs_size) {
+    fetx_netlist_assign_output(copy, nl.outputs[i], i);
+    ++i;
+  }
+  i = 0;
+  while (i < nl.supplies_size) {
+    fetx_netlist_assign_supply(copy, nl.supplies[i], i);
+    ++i;
+  }
+  return 0;
+}
+
+/* traces every node and checks the trace ends in the final node states */
+
+static int fetx_test_trace_format(const struct fetx_test_case *const tc,
+                                  const enum fetx_trace_formats format) {
+  static const unsigned char vcd_values[] = {'0', '1', 'x', 'x', 'x', 'z'};
+  const struct fetx_test_opts opts = {
+      .name = (format == FETX_TRACE_VCD) ? "trace vcd" : "trace bin",
+      .check_time = 1};
+  struct fetx_io io;
+  if (fetx_io_init(&io, tc->nl) != 0) {
+    return -1;
+  }
+  const size_t size = io.fx.nodes_limit - io.fx.nodes;
+  size_t *const nodes = fetx_alloc(sizeof(*nodes), size);
+  unsigned char *const states = fetx_alloc(sizeof(*states), size);
+  FILE *const fd = tmpfile();
+  int ret = -1;
+  if ((nodes != 0) && (states != 0) && (fd != 0)) {
+    size_t i = 0;
+    while (i < size) {
+      nodes[i] = i;
+      ++i;
+    }
+    struct fetx_trace trace;
+    if (fetx_trace_open_fd(&trace, &io, nodes, size, fd, format, 0) ==
+        FETX_ERR_NONE) {
+      const int run = fetx_test_run_io(tc, &opts, &io);
+      if ((fetx_trace_close_fd(&trace, &io) == FETX_ERR_NONE) &&
+          (run == 0) && (fseek(fd, 0, SEEK_SET) == 0) &&
+          (fetx_test_trace_read(states, size, fd, format) == 0)) {
+        ret = 0;
+        i = 0;
+        while (i < size) {
+          const enum fetx_node_states state =
+              fetx_node_state_get(io.fx.nodes[i]);
+          if (states[i] !=
+              ((format == FETX_TRACE_VCD) ? vcd_values[state] : state)) {
+            ret = -1;
+          }
+          ++i;
+        }
+      }
+    }
+  }
+  if (fd != 0) {
+    fclose(fd);
+  }
+  fetx_dealloc(nodes);
+  fetx_dealloc(states);
+  fetx_io_delete(io);
+  if (ret != 0) {
+    printf("Simulation failed (%s): trace does not match node states\n",
+           opts.name);
+  }
+  return ret;
+}
+
+int fetx_test_trace(const struct fetx_test_case *const tc) {
+  return ((fetx_test_trace_format(tc, FETX_TRACE_VCD) == 0) &&
+          (fetx_test_trace_format(tc, FETX_TRACE_BIN) == 0))
+             ? 0
+             : -1;
+}
+
+/* drives the netlist through the opaque handle API, one row per step */
+
+int fetx_test_handle(const struct fetx_test_case *const tc) {
+  struct fetx_handle *const handle = fetx_handle_new(&tc->nl, 0);
+  unsigned char *const inputs =
+      fetx_alloc(sizeof(*inputs), tc->input_vec.width);
+  unsigned char *const outputs =
+      fetx_alloc(sizeof(*outputs), tc->correct_vec.width);
+  int ret = -1;
+  if ((handle != 0) && (inputs != 0) && (outputs != 0) &&
+      (fetx_handle_inputs_size(handle) == tc->input_vec.width) &&
+      (fetx_handle_outputs_size(handle) == tc->correct_vec.width)) {
+    unsigned long int time = 0;
+    unsigned long int multiply_driven = 0;
+    ret = 0;
+    size_t t = 0;
+    while ((ret == 0) && (t < tc->input_vec.length)) {
+      size_t i = 0;
+      while (i < tc->input_vec.width) {
+        inputs[i] = (unsigned char)tc->input_vec.values[t][i];
+        ++i;
+      }
+      if (fetx_handle_step(handle, inputs, outputs, tc->time_limit, &time) !=
+          0) {
+        ret = -1;
+      }
+      multiply_driven += fetx_handle_multiple_driven(handle);
+      i = 0;
+      while (i < tc->correct_vec.width) {
+        if ((outputs[i] != tc->correct_vec.values[t][i]) ||
+            (fetx_handle_output_get(handle, i) !=
+             tc->correct_vec.values[t][i])) {
+          ret = -1;
+        }
+        ++i;
+      }
+      ++t;
+    }
+    if ((time != tc->correct_res.time) ||
+        (multiply_driven != tc->correct_res.multiply_driven)) {
+      ret = -1;
+    }
+  }
+  fetx_handle_delete(handle);
+  fetx_dealloc(inputs);
+  fetx_dealloc(outputs);
+  if (ret != 0) {
+    puts("Simulation failed (handle): results do not match");
+  }
+  return ret;
+}
+
+/* runs the vector on several farm instances, split into two jobs each that
+ * must continue from one another */
+
+int fetx_test_farm(const struct fetx_test_case *const tc) {
+  const struct fetx_test_opts opts = {.name = "farm", .check_time = 1};
+  const size_t instances_size = 3;
+  const size_t split = tc->input_vec.length / 2;
+  struct fetx_vector output_vecs[3];
+  struct fetx_farm_job jobs[3][2];
+  struct fetx_farm farm;
+  /* lazily built, so each instance copies the graph and builds its own */
+  if (fetx_farm_init(&farm, tc->nl, (struct fetx_io_opts){.lazy = 1},
+                     instances_size, 2) != FETX_ERR_NONE) {
+    puts("Simulation failed (farm): could not initialise");
+    return -1;
+  }
+  size_t i = 0;
+  while (i < instances_size) {
+    output_vecs[i].width = tc->correct_vec.width;
+    output_vecs[i].length = tc->correct_vec.length;
+    if (fetx_vector_new(&output_vecs[i]) != 0) {
+      while (i > 0) {
+        --i;
+        fetx_vector_delete(output_vecs[i]);
+      }
+      fetx_farm_delete(&farm);
+      return -1;
+    }
+    size_t j = 0;
+    while (j < 2) {
+      const size_t start = (j == 0) ? 0 : split;
+      struct fetx_farm_job *const job = &jobs[i][j];
+      job->inputs.values = tc->input_vec.values + start;
+      job->inputs.width = tc->input_vec.width;
+      job->inputs.length = ((j == 0) ? split : tc->input_vec.length) - start;
+      job->outputs.values = output_vecs[i].values + start;
+      job->outputs.width = output_vecs[i].width;
+      job->outputs.length = job->inputs.length;
+      job->time_limit = tc->time_limit;
+      fetx_farm_submit(&farm, i, job);
+      ++j;
+    }
+    ++i;
+  }
+  fetx_farm_wait(&farm);
+
+  int ret = 0;
+  i = 0;
+  while (i < instances_size) {
+    const struct fetx_sim_res res = {
+        .time = jobs[i][0].res.time + jobs[i][1].res.time,
+        .multiply_driven =
+            jobs[i][0].res.multiply_driven + jobs[i][1].res.multiply_driven};
+    if (fetx_test_results(tc, &opts, jobs[i][0].errs | jobs[i][1].errs, res,
+                          output_vecs[i]) != 0) {
+      ret = -1;
+    }
+    fetx_vector_delete(output_vecs[i]);
+    ++i;
+  }
+  fetx_farm_delete(&farm);
+  return ret;
+}
+
+/* splits the vector into single row chunks over several workers */
+
+int fetx_test_batch(const struct fetx_test_case *const tc) {
+  const struct fetx_test_opts opts = {.name = "batch", .check_time = 1};
+  struct fetx_vector output_vec;
+  if (fetx_test_outputs_new(&output_vec, tc) != 0) {
+    return -1;
+  }
+  struct fetx_sim_res res;
+  const enum fetx_errs errs = fetx_vector_sim_batch(
+      &res, output_vec, tc->nl, opts.io_opts, tc->input_vec, tc->time_limit,
+      3, 1);
+  const int ret = fetx_test_results(tc, &opts, errs, res, output_vec);
+  fetx_vector_delete(output_vec);
+  return ret;
+}
+
+/* counts the images in a cache directory, removing them if \clear */
+
+static size_t fetx_test_cache_images(const char *const dir, const int clear) {
+  DIR *const d = opendir(dir);
+  if (d == 0) {
+    return 0;
+  }
+  size_t count = 0;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != 0) {
+    if (ent->d_name[0] != '.') {
+      if (clear != 0) {
+        unlinkat(dirfd(d), ent->d_name, 0);
+      }
+      ++count;
+    }
+  }
+  closedir(d);
+  return count;
+}
+
+static int fetx_test_cache_sim(const struct fetx_test_case *const tc,
+                               const struct fetx_cache cache,
+                               const struct fetx_test_opts *const opts) {
+  struct fetx_io io;
+  if (fetx_cache_io_init(&io, cache, tc->nl, opts->io_opts) !=
+      FETX_ERR_NONE) {
+    printf("Simulation failed (%s): could not initialise\n", opts->name);
+    return -1;
+  }
+  const int ret = fetx_test_run_io(tc, opts, &io);
+  fetx_io_delete(io);
+  return ret;
+}
+
+/* builds the runtime, then loads it from the cache, then stores a second
+ * image in a cache only big enough for one */
+
+int fetx_test_cache(const struct fetx_test_case *const tc) {
+  char dir[] = "/tmp/fetx_test_cache.XXXXXX";
+  if (mkdtemp(dir) == 0) {
+    puts("Simulation failed (cache): could not create directory");
+    return -1;
+  }
+  struct fetx_cache cache = {.dir = dir, .size_limit = 0};
+  struct fetx_test_opts opts = {.name = "cache", .check_time = 1};
+  int ret = 0;
+  if ((fetx_test_cache_sim(tc, cache, &opts) != 0) ||
+      (fetx_test_cache_images(dir, 0) != 1) ||
+      (fetx_test_cache_sim(tc, cache, &opts) != 0)) {
+    puts("Simulation failed (cache): results do not match");
+    ret = -1;
+  }
+  /* temporary images left by writers that stopped, only the old one is
+   * removed */
+  char stale[sizeof(dir) + 16];
+  char fresh[sizeof(dir) + 16];
+  snprintf(stale, sizeof(stale), "%s/.fxi.stale", dir);
+  snprintf(fresh, sizeof(fresh), "%s/.fxi.fresh", dir);
+  FILE *fd = fopen(stale, "w");
+  if (fd != 0) {
+    fclose(fd);
+  }
+  fd = fopen(fresh, "w");
+  if (fd != 0) {
+    fclose(fd);
+  }
+  const struct timeval old[2] = {{.tv_sec = time(0) - (2 * 60 * 60)},
+                                 {.tv_sec = time(0) - (2 * 60 * 60)}};
+  utimes(stale, old);
+  cache.size_limit = 1;
+  opts.io_opts.levelise = 1;
+  opts.check_time = 0;
+  if ((ret == 0) && ((fetx_test_cache_sim(tc, cache, &opts) != 0) ||
+                     (fetx_test_cache_images(dir, 0) != 1))) {
+    puts("Simulation failed (cache): eviction");
+    ret = -1;
+  }
+  if ((ret == 0) &&
+      ((access(stale, F_OK) == 0) || (access(fresh, F_OK) != 0))) {
+    puts("Simulation failed (cache): stale temporary images not removed");
+    ret = -1;
+  }
+  unlink(stale);
+  unlink(fresh);
+  fetx_test_cache_images(dir, 1);
+  rmdir(dir);
+  return ret;
+}
+
+/* simulates the fan-in cone of the first and last outputs and checks them
+ * against those columns */
+
+int fetx_test_cone(const struct fetx_test_case *const tc) {
+  const size_t outputs[2] = {0, tc->nl.outputs_size - 1};
+  struct fetx_netlist cone;
+  if (fetx_netlist_cone(&cone, 0, tc->nl, outputs, 2) != FETX_ERR_NONE) {
+    puts("Simulation failed (cone): could not prune netlist");
+    return -1;
+  }
+  struct fetx_vector output_vec = {.width = 2,
+                                   .length = tc->correct_vec.length};
+  if (fetx_vector_new(&output_vec) != 0) {
+    fetx_netlist_delete(cone);
+    return -1;
+  }
+  struct fetx_sim_res res;
+  const enum fetx_errs errs =
+      fetx_vector_sim(&res, output_vec, cone, tc->input_vec, tc->time_limit);
+  int ret = (errs == FETX_ERR_NONE) ? 0 : -1;
+  size_t t = 0;
+  while ((ret == 0) && (t < tc->correct_vec.length)) {
+    if ((output_vec.values[t][0] != tc->correct_vec.values[t][outputs[0]]) ||
+        (output_vec.values[t][1] != tc->correct_vec.values[t][outputs[1]])) {
+      ret = -1;
+    }
+    ++t;
+  }
+  if (ret != 0) {
+    printf("Simulation failed (cone): %u, row %lu\n", errs,
+           (unsigned long int)t);
+  }
+  fetx_vector_delete(output_vec);
+  fetx_netlist_delete(cone);
+  return ret;
+}
+
+/* simulates \tc with its cells memoised, a cell can be looked up without its
+ * paths being walked so the FETs its nodes control are only stepped when
+ * their gates change, which can shorten the time */
+
+int fetx_test_memo(const struct fetx_test_case *const tc) {
+  const struct fetx_test_opts opts = {
+      .name = "memo", .io_opts = {.memo = 1}, .check_time_max = 1};
+  struct fetx_io io;
+  if (fetx_io_init_opts(&io, tc->nl, opts.io_opts) != 0) {
+    puts("Simulation failed (memo): could not initialise");
+    return -1;
+  }
+  int ret = fetx_test_run_io(tc, &opts, &io);
+  struct fetx_io_memo memo;
+  fetx_io_memo_stats(&memo, &io);
+  fetx_io_delete(io);
+  if ((ret == 0) && (memo.cells != 0) && (memo.misses == 0)) {
+    puts("Simulation failed (memo): cells not looked up");
+    ret = -1;
+  }
+  return ret;
+}
+
+/* declares inputs 0 and 1 as the ground and power supplies when the vector
+ * holds them there, and drops their columns */
+
+int fetx_test_supplies(const struct fetx_test_case *const tc) {
+  const struct fetx_netlist nl = tc->nl;
+  size_t t = 0;
+  while (t < tc->input_vec.length) {
+    if ((nl.inputs_size < 2) || (tc->input_vec.values[t][0] != FETX_LOW) ||
+        (tc->input_vec.values[t][1] != FETX_HIGH)) {
+      return 0;
+    }
+    ++t;
+  }
+
+  struct fetx_test_case supplied = *tc;
+  supplied.input_vec.width -= 2;
+  supplied.input_vec.values =
+      fetx_alloc(sizeof(*supplied.input_vec.values), tc->input_vec.length);
+  if (supplied.input_vec.values == 0) {
+    return -1;
+  }
+  if (fetx_test_netlist_copy(&supplied.nl, nl, 2, 2) != 0) {
+    fetx_dealloc(supplied.input_vec.values);
+    return -1;
+  }
+  fetx_netlist_assign_supply(
+      &supplied.nl,
+      (struct fetx_netlist_supply){.node = nl.inputs[0], .state = FETX_LOW},
+      nl.supplies_size);
+  fetx_netlist_assign_supply(
+      &supplied.nl,
+      (struct fetx_netlist_supply){.node = nl.inputs[1], .state = FETX_HIGH},
+      nl.supplies_size + 1);
+  t = 0;
+  while (t < tc->input_vec.length) {
+    supplied.input_vec.values[t] = tc->input_vec.values[t] + 2;
+    ++t;
+  }
+
+  /* copies and images hold the supplies too */
+  const struct fetx_test_opts opts = {.name = "supplies", .check_time = 1};
+  const int ret = ((fetx_test_variant(&supplied, &opts) == 0) &&
+                   (fetx_test_memo(&supplied) == 0) &&
+                   (fetx_test_farm(&supplied) == 0) &&
+                   (fetx_test_cache(&supplied) == 0))
+                      ? 0
+                      : -1;
+  if (ret != 0) {
+    puts("Simulation failed (supplies): with inputs 0 and 1 as supplies");
+  }
+  fetx_dealloc(supplied.input_vec.values);
+  fetx_netlist_delete(supplied.nl);
+  return ret;
+}
+
+/* 1 if the paths of \a and \b are counted and linked to the FETs alike */
+
+static int fetx_test_same_paths(const struct fetx *const a,
+                                const struct fetx *const b) {
+  if (((a->nodes_limit - a->nodes) != (b->nodes_limit - b->nodes)) ||
+      (a->wide_counts_size != b->wide_counts_size)) {
+    return 0;
+  }
+  const struct fetx_node *node_a = a->nodes;
+  const struct fetx_node *node_b = b->nodes;
+  while (node_a != a->nodes_limit) {
+    if ((node_a->paths != node_b->paths) ||
+        (node_a->is_wide != node_b->is_wide) ||
+        (node_a->is_input != node_b->is_input) ||
+        ((node_a->is_wide != 0) &&
+         (node_a->counts.wide != node_b->counts.wide))) {
+      return 0;
+    }
+    ++node_a;
+    ++node_b;
+  }
+  const struct fetx_fet *fet_a = a->fets;
+  const struct fetx_fet *fet_b = b->fets;
+  while (fet_a != a->fets_limit) {
+    const struct fetx_link *link_a = fet_a->links;
+    const struct fetx_link *link_b = fet_b->links;
+    while ((link_a != 0) && (link_b != 0)) {
+      if (((link_a->input->node - a->nodes) !=
+           (link_b->input->node - b->nodes)) ||
+          ((link_a->output->node - a->nodes) !=
+           (link_b->output->node - b->nodes))) {
+        return 0;
+      }
+      link_a = link_a->next;
+      link_b = link_b->next;
+    }
+    if (link_a != link_b) {
+      return 0;
+    }
+    ++fet_a;
+    ++fet_b;
+  }
+  return 1;
+}
+
+/* paths built on several threads must give the runtime serial init does */
+
+int fetx_test_workers(const struct fetx_test_case *const tc) {
+  struct fetx_io serial;
+  struct fetx_io parallel;
+  if (fetx_io_init(&serial, tc->nl) != 0) {
+    puts("Simulation failed (workers): could not initialise");
+    return -1;
+  }
+  if (fetx_io_init_opts(&parallel, tc->nl,
+                        (struct fetx_io_opts){.init_workers = 4}) != 0) {
+    puts("Simulation failed (workers): could not initialise");
+    fetx_io_delete(serial);
+    return -1;
+  }
+  /* the threads hold their own path markers on top */
+  const int same = fetx_test_same_paths(&serial.fx, &parallel.fx) &&
+                   (serial.stats.elements_built ==
+                    parallel.stats.elements_built) &&
+                   (serial.stats.peak_bytes_estimate != 0) &&
+                   (parallel.stats.peak_bytes_estimate >
+                    serial.stats.peak_bytes_estimate);
+  fetx_io_delete(serial);
+  fetx_io_delete(parallel);
+  if (same == 0) {
+    puts("Simulation failed (workers): runtime differs from serial init");
+    return -1;
+  }
+
+  struct fetx_test_opts opts = {
+      .name = "workers", .io_opts = {.init_workers = 4}, .check_time = 1};
+  if (fetx_test_variant(tc, &opts) != 0) {
+    return -1;
+  }
+  opts.name = "lazy workers";
+  opts.io_opts.lazy = 1;
+  return fetx_test_variant(tc, &opts);
+}
+
+/* the estimate must match what is built, and a budget below it must either
+ * be refused or met by folding */
+
+int fetx_test_budget(const struct fetx_test_case *const tc) {
+  const struct fetx_netlist nl = tc->nl;
+  struct fetx_io_estimate est;
+  if (fetx_io_estimate(&est, 0, nl, 0) != FETX_ERR_NONE) {
+    puts("Simulation failed (budget): could not estimate");
+    return -1;
+  }
+  struct fetx_io io;
+  if (fetx_io_init_budget(&io, nl, (struct fetx_io_opts){.levelise = 0},
+                          est.peak_bytes) != FETX_ERR_NONE) {
+    puts("Simulation failed (budget): estimate over the budget it gives");
+    return -1;
+  }
+  /* side tables for nodes with many paths aren't estimated */
+  int ret = ((est.capped != 0) || (est.elements != io.stats.elements_built) ||
+             (est.peak_bytes > io.stats.peak_bytes_estimate) ||
+             (io.stats.folded != 0))
+                ? -1
+                : 0;
+  fetx_io_delete(io);
+  if (ret != 0) {
+    puts("Simulation failed (budget): estimate does not match the runtime");
+    return -1;
+  }
+
+  const enum fetx_errs errs = fetx_io_init_budget(
+      &io, nl, (struct fetx_io_opts){.levelise = 0}, est.peak_bytes - 1);
+  if (errs == FETX_ERR_NONE) {
+    /* folded to fit, which the caller is told of */
+    ret = ((nl.supplies_size == 0) || (io.stats.folded == 0) ||
+           (io.stats.peak_bytes_estimate >= est.peak_bytes))
+              ? -1
+              : 0;
+    fetx_io_delete(io);
+  } else if (errs != FETX_ERR_BUDGET) {
+    ret = -1;
+  }
+  if (ret != 0) {
+    puts("Simulation failed (budget): budget not kept");
+    return -1;
+  }
+
+  /* stops at the cap */
+  if (est.elements > 1) {
+    if ((fetx_io_estimate(&est, 0, nl, 1) != FETX_ERR_NONE) ||
+        (est.capped == 0) || (est.elements != 1)) {
+      puts("Simulation failed (budget): cap not kept");
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* every FET of a unit delay netlist given the same delay, which spaces the
+ * steps out without changing the order they happen in */
+
+int fetx_test_delays(const struct fetx_test_case *const tc) {
+  const unsigned int delay = 3;
+  size_t i = 0;
+  while (i < tc->nl.fl.size) {
+    if (tc->nl.fl.fets[i].delay > 1) {
+      return 0;
+    }
+    ++i;
+  }
+
+  struct fetx_test_case delayed = *tc;
+  if (fetx_test_netlist_copy(&delayed.nl, tc->nl, 0, 0) != 0) {
+    return -1;
+  }
+  i = 0;
+  while (i < delayed.nl.fl.size) {
+    delayed.nl.fl.fets[i].delay = delay;
+    ++i;
+  }
+  delayed.correct_res.time *= delay;
+  delayed.time_limit *= delay;
+
+  const struct fetx_test_opts opts = {.name = "delays", .check_time = 1};
+  const int ret =
+      ((fetx_test_variant(&delayed, &opts) == 0) &&
+       (fetx_test_handle(&delayed) == 0) && (fetx_test_farm(&delayed) == 0) &&
+       (fetx_test_batch(&delayed) == 0) && (fetx_test_cache(&delayed) == 0))
+          ? 0
+          : -1;
+  if (ret != 0) {
+    puts("Simulation failed (delays): with every FET delayed");
+  }
+  fetx_netlist_delete(delayed.nl);
+  return ret;
+}
+
+/* checked against a copy of the expected outputs with a state changed in two
+ * rows, which stops at the first unless more are allowed and passes if they
+ * are masked out */
+
+int fetx_test_check(const struct fetx_test_case *const tc) {
+  if ((tc->correct_vec.length < 2) || (tc->correct_vec.width == 0)) {
+    return 0;
+  }
+  struct fetx_vector wrong = {.width = tc->correct_vec.width,
+                              .length = tc->correct_vec.length};
+  unsigned char **const care =
+      fetx_alloc(sizeof(*care), tc->correct_vec.length);
+  unsigned char *const cares =
+      fetx_alloc(tc->correct_vec.width, tc->correct_vec.length);
+  if ((care == 0) || (cares == 0) || (fetx_vector_new(&wrong) != 0)) {
+    fetx_dealloc(care);
+    fetx_dealloc(cares);
+    return -1;
+  }
+  size_t t = 0;
+  while (t < wrong.length) {
+    care[t] = cares + (t * wrong.width);
+    size_t i = 0;
+    while (i < wrong.width) {
+      wrong.values[t][i] = tc->correct_vec.values[t][i];
+      care[t][i] = 1;
+      ++i;
+    }
+    ++t;
+  }
+  const size_t rows[2] = {(wrong.length - 1) / 2, wrong.length - 1};
+  const size_t outputs[2] = {0, wrong.width - 1};
+  t = 0;
+  while (t < 2) {
+    enum fetx_node_states *const state = wrong.values[rows[t]] + outputs[t];
+    *state = (*state == FETX_LOW) ? FETX_HIGH : FETX_LOW;
+    care[rows[t]][outputs[t]] = 0;
+    ++t;
+  }
+
+  int ret = 0;
+  struct fetx_sim_res res;
+  struct fetx_vector_check check = {.expected = wrong};
+  if ((fetx_vector_check(&res, &check, tc->nl, tc->input_vec,
+                         tc->time_limit) != FETX_ERR_MISMATCH) ||
+      (check.mismatches != 1) || (check.row != rows[0]) ||
+      (check.output != 0) ||
+      (check.actual != tc->correct_vec.values[rows[0]][0])) {
+    puts("Simulation failed (check): first mismatch not reported");
+    ret = -1;
+  }
+  check.mismatches_limit = 3;
+  if ((ret == 0) &&
+      ((fetx_vector_check(&res, &check, tc->nl, tc->input_vec,
+                          tc->time_limit) != FETX_ERR_MISMATCH) ||
+       (check.mismatches != 2) || (check.row != rows[0]) ||
+       (res.time != tc->correct_res.time))) {
+    puts("Simulation failed (check): mismatches not counted to the end");
+    ret = -1;
+  }
+  check.care = (const unsigned char *const *)care;
+  if ((ret == 0) &&
+      ((fetx_vector_check(&res, &check, tc->nl, tc->input_vec,
+                          tc->time_limit) != FETX_ERR_NONE) ||
+       (check.mismatches != 0) || (res.time != tc->correct_res.time) ||
+       (res.multiply_driven != tc->correct_res.multiply_driven))) {
+    puts("Simulation failed (check): masked outputs compared");
+    ret = -1;
+  }
+  fetx_vector_delete(wrong);
+  fetx_dealloc(care);
+  fetx_dealloc(cares);
+  return ret;
+}
+
+/* runs \rows rows of \stim both through the stimulus driver and, collected
+ * into a vector, through fetx_vector_sim, the two must agree */
+
+static int fetx_test_stim_sim(const char *const name,
+                              const struct fetx_netlist nl,
+                              struct fetx_stim *const stim,
+                              const struct fetx_vector rows,
+                              unsigned long int time_limit) {
+  struct fetx_vector a = {.width = nl.outputs_size, .length = rows.length};
+  struct fetx_vector b = a;
+  if (fetx_vector_new(&a) != 0) {
+    return -1;
+  }
+  if (fetx_vector_new(&b) != 0) {
+    fetx_vector_delete(a);
+    return -1;
+  }
+  struct fetx_sim_res res_a;
+  struct fetx_sim_res res_b;
+  struct fetx_sim_res res_c;
+  fetx_stim_reset(stim);
+  const enum fetx_errs errs_a =
+      fetx_vector_sim_stim(&res_a, a, nl, stim, rows.length, time_limit);
+  const enum fetx_errs errs_b =
+      fetx_vector_sim(&res_b, b, nl, rows, time_limit);
+  /* outputs dropped */
+  fetx_stim_reset(stim);
+  const enum fetx_errs errs_c =
+      fetx_vector_sim_stim(&res_c, (struct fetx_vector){.values = 0}, nl, stim,
+                           rows.length, time_limit);
+  int ret = 0;
+  if ((errs_a != errs_b) || (errs_c != errs_b) ||
+      (res_a.time != res_b.time) || (res_c.time != res_b.time) ||
+      (res_a.multiply_driven != res_b.multiply_driven) ||
+      ((errs_a == FETX_ERR_NONE) && (vector_compare(a, b) != 0))) {
+    printf("Simulation failed (%s): stimulus driver differs from vector\n",
+           name);
+    ret = -1;
+  }
+  fetx_vector_delete(a);
+  fetx_vector_delete(b);
+  return ret;
+}
+
+/* random and Gray code stimulus, with the columns the test vector holds
+ * constant, such as the rails, fixed */
+
+int fetx_test_stim(const struct fetx_test_case *const tc) {
+  const struct fetx_netlist nl = tc->nl;
+  const struct fetx_vector input_vec = tc->input_vec;
+  const unsigned long int time_limit = tc->time_limit;
+  const size_t width = nl.inputs_size;
+  const size_t length = 64;
+  enum fetx_stim_columns *const columns =
+      fetx_alloc(sizeof(*columns), width + 1);
+  struct fetx_vector rows = {.width = width, .length = length};
+  if ((columns == 0) || (fetx_vector_new(&rows) != 0)) {
+    fetx_dealloc(columns);
+    return -1;
+  }
+  size_t free_size = 0;
+  size_t i = 0;
+  while (i < width) {
+    const enum fetx_node_states state = input_vec.values[0][i];
+    size_t t = 1;
+    while ((t < input_vec.length) && (input_vec.values[t][i] == state)) {
+      ++t;
+    }
+    if ((t == input_vec.length) && (input_vec.length > 1) &&
+        ((state == FETX_LOW) || (state == FETX_HIGH))) {
+      columns[i] = (state == FETX_LOW) ? FETX_STIM_LOW : FETX_STIM_HIGH;
+    } else if (free_size < 6) {
+      columns[i] = FETX_STIM_FREE;
+      ++free_size;
+    } else {
+      columns[i] = FETX_STIM_LOW;
+    }
+    ++i;
+  }
+
+  int ret = 0;
+  struct fetx_stim stim;
+  if (fetx_stim_new(&stim, FETX_STIM_RANDOM, columns, width, 7) !=
+      FETX_ERR_NONE) {
+    puts("Simulation failed (stim): could not create random stimulus");
+    fetx_dealloc(columns);
+    fetx_vector_delete(rows);
+    return -1;
+  }
+  size_t t = 0;
+  while (t < length) {
+    const enum fetx_node_states *const row = fetx_stim_next(&stim);
+    i = 0;
+    while (i < width) {
+      rows.values[t][i] = row[i];
+      if (((columns[i] == FETX_STIM_LOW) && (row[i] != FETX_LOW)) ||
+          ((columns[i] == FETX_STIM_HIGH) && (row[i] != FETX_HIGH))) {
+        ret = -1;
+      }
+      ++i;
+    }
+    ++t;
+  }
+  if (ret != 0) {
+    puts("Simulation failed (stim): fixed column changed");
+  } else {
+    ret = fetx_test_stim_sim("stim random", nl, &stim, rows, time_limit);
+  }
+  fetx_stim_delete(stim);
+
+  /* the last free column as a clock, the rest counted through */
+  i = width;
+  while ((i != 0) && (columns[i - 1] != FETX_STIM_FREE)) {
+    --i;
+  }
+  if (i != 0) {
+    columns[i - 1] = FETX_STIM_CLOCK;
+    --free_size;
+  }
+  if ((ret == 0) && (fetx_stim_new(&stim, FETX_STIM_GRAY, columns, width, 0) !=
+                     FETX_ERR_NONE)) {
+    puts("Simulation failed (stim): could not create Gray code stimulus");
+    ret = -1;
+  }
+  if (ret == 0) {
+    const size_t clock = (i != 0) ? i - 1 : width;
+    const unsigned long long int cycle = fetx_stim_length(&stim);
+    unsigned char seen[64] = {0};
+    rows.length = (cycle < length) ? (size_t)cycle : length;
+    t = 0;
+    while ((ret == 0) && (t < rows.length)) {
+      const enum fetx_node_states *const row = fetx_stim_next(&stim);
+      size_t code = 0;
+      size_t changes = 0;
+      size_t j = 0;
+      i = 0;
+      while (i < width) {
+        if (columns[i] == FETX_STIM_FREE) {
+          code |= (size_t)(row[i] == FETX_HIGH) << j;
+          ++j;
+          changes += (t != 0) && (row[i] != rows.values[t - 1][i]);
+        }
+        rows.values[t][i] = row[i];
+        ++i;
+      }
+      const int is_high = (clock != width) && ((t & 1) != 0);
+      if ((clock != width) &&
+          (row[clock] != (is_high ? FETX_HIGH : FETX_LOW))) {
+        puts("Simulation failed (stim): clock out of phase");
+        ret = -1;
+      } else if ((is_high && (changes != 0)) ||
+                 (!is_high && (t != 0) && (changes != 1))) {
+        puts("Simulation failed (stim): not one change per Gray code step");
+        ret = -1;
+      } else if (!is_high && (seen[code] != 0)) {
+        puts("Simulation failed (stim): Gray code repeated");
+        ret = -1;
+      }
+      seen[code] = 1;
+      ++t;
+    }
+    /* the row after the last is the first again */
+    if ((ret == 0) && (cycle <= length)) {
+      fetx_stim_reset(&stim);
+      t = 0;
+      while (t < cycle) {
+        fetx_stim_next(&stim);
+        ++t;
+      }
+      const enum fetx_node_states *const row = fetx_stim_next(&stim);
+      i = 0;
+      while ((ret == 0) && (i < width)) {
+        if (row[i] != rows.values[0][i]) {
+          puts("Simulation failed (stim): Gray code does not start again");
+          ret = -1;
+        }
+        ++i;
+      }
+    }
+    if (ret == 0) {
+      ret = fetx_test_stim_sim("stim gray", nl, &stim, rows, time_limit);
+    }
+    fetx_stim_delete(stim);
+  }
+  fetx_dealloc(columns);
+  fetx_vector_delete(rows);
+
+  /* 63 free columns and a clock would take 2^64 rows */
+  static const enum fetx_stim_columns too_wide[64] = {FETX_STIM_CLOCK};
+  if ((ret == 0) && (fetx_stim_new(&stim, FETX_STIM_GRAY, too_wide, 64, 0) !=
+                     FETX_ERR_PARAM)) {
+    puts("Simulation failed (stim): Gray code length not limited");
+    fetx_stim_delete(stim);
+    ret = -1;
+  }
+  return ret;
+}
+
+/* the last input driven as a clock low, high and high again for each row,
+ * the last phase changing nothing, which must match a vector with a row per
+ * phase */
+
+int fetx_test_clocked(const struct fetx_test_case *const tc) {
+  const struct fetx_netlist nl = tc->nl;
+  const struct fetx_vector input_vec = tc->input_vec;
+  if (nl.inputs_size == 0) {
+    return 0;
+  }
+  const size_t clock = nl.inputs_size - 1;
+  const size_t phases_size = 3;
+  const enum fetx_node_states levels[3] = {FETX_LOW, FETX_HIGH, FETX_HIGH};
+  const unsigned char sample_all[3] = {1, 1, 1};
+  const enum fetx_node_states *phases[3] = {levels, levels + 1, levels + 2};
+  struct fetx_vector_clocks clocks = {
+      .inputs = &clock,
+      .inputs_size = 1,
+      .phases = {.values = (enum fetx_node_states **)phases,
+                 .width = 1,
+                 .length = phases_size}};
+  const unsigned long int time_limit =
+      (tc->time_limit > (ULONG_MAX / phases_size))
+          ? 0
+          : tc->time_limit * phases_size;
+
+  struct fetx_vector expanded = {.width = nl.inputs_size,
+                                 .length = input_vec.length * phases_size};
+  struct fetx_vector correct = {.width = nl.outputs_size,
+                                .length = expanded.length};
+  struct fetx_vector out = correct;
+  if (fetx_vector_new(&expanded) != 0) {
+    return -1;
+  }
+  if (fetx_vector_new(&correct) != 0) {
+    fetx_vector_delete(expanded);
+    return -1;
+  }
+  if (fetx_vector_new(&out) != 0) {
+    fetx_vector_delete(expanded);
+    fetx_vector_delete(correct);
+    return -1;
+  }
+  size_t t = 0;
+  while (t < expanded.length) {
+    size_t i = 0;
+    while (i < expanded.width) {
+      expanded.values[t][i] = input_vec.values[t / phases_size][i];
+      ++i;
+    }
+    expanded.values[t][clock] = levels[t % phases_size];
+    ++t;
+  }
+  struct fetx_sim_res correct_res;
+  struct fetx_sim_res res;
+  const enum fetx_errs correct_errs =
+      fetx_vector_sim(&correct_res, correct, nl, expanded, time_limit);
+
+  /* the outputs after every phase */
+  clocks.sample = sample_all;
+  enum fetx_errs errs =
+      fetx_vector_sim_clocked(&res, out, nl, clocks, input_vec, time_limit);
+  int ret = 0;
+  if ((errs != correct_errs) || (res.time != correct_res.time) ||
+      (res.multiply_driven != correct_res.multiply_driven) ||
+      ((errs == FETX_ERR_NONE) && (vector_compare(out, correct) != 0))) {
+    puts("Simulation failed (clocked): phases differ from vector");
+    ret = -1;
+  }
+
+  /* the outputs after the last phase only */
+  clocks.sample = 0;
+  out.length = input_vec.length;
+  if (ret == 0) {
+    errs =
+        fetx_vector_sim_clocked(&res, out, nl, clocks, input_vec, time_limit);
+    t = 0;
+    while ((errs == FETX_ERR_NONE) && (t < out.length)) {
+      size_t i = 0;
+      while (i < out.width) {
+        if (out.values[t][i] !=
+            correct.values[(t * phases_size) + phases_size - 1][i]) {
+          ret = -1;
+        }
+        ++i;
+      }
+      ++t;
+    }
+    if ((ret != 0) || (errs != correct_errs) ||
+        (res.time != correct_res.time)) {
+      puts("Simulation failed (clocked): last phases differ from vector");
+      ret = -1;
+    }
+  }
+  fetx_vector_delete(expanded);
+  fetx_vector_delete(correct);
+  fetx_vector_delete(out);
+  return ret;
+}
+
+/* renumbered for locality */
+
+int fetx_test_reorder(const struct fetx_test_case *const tc) {
+  struct fetx_test_case reordered = *tc;
+  struct fetx_netlist_map map;
+  if (fetx_netlist_reorder(&reordered.nl, &map, tc->nl) != FETX_ERR_NONE) {
+    puts("Simulation failed (reorder): could not reorder netlist");
+    return -1;
+  }
+  const struct fetx_test_opts opts = {.name = "reorder", .check_time = 1};
+  const int ret = fetx_test_variant(&reordered, &opts);
+  fetx_netlist_delete(reordered.nl);
+  fetx_netlist_map_delete(map);
+  return ret;
+}
+
+int fetx_test_variants(const struct fetx_test_case *const tc) {
+  static const struct fetx_test_opts variants[] = {
+      /* resolved in level order, which changes the time taken */
+      {.name = "levelise", .io_opts = {.levelise = 1}},
+      /* tied off FETs folded into the supplies, those held on no longer take
+       * a step so the time can be shorter */
+      {.name = "fold", .io_opts = {.fold = 1}},
+      /* inputs built on their first change, which doesn't change the time */
+      {.name = "lazy", .io_opts = {.lazy = 1}, .check_time = 1}};
+  static int (*const tests[])(const struct fetx_test_case *const) = {
+      fetx_test_reorder, fetx_test_memo,     fetx_test_workers,
+      fetx_test_budget,  fetx_test_cone,     fetx_test_trace,
+      fetx_test_handle,  fetx_test_farm,     fetx_test_batch,
+      fetx_test_cache,   fetx_test_check,    fetx_test_delays,
+      fetx_test_stim,    fetx_test_clocked,  fetx_test_supplies};
+
+  size_t i = 0;
+  while (i < (sizeof(variants) / sizeof(*variants))) {
+    if (fetx_test_variant(tc, variants + i) != 0) {
+      return -1;
+    }
+    ++i;
+  }
+  i = 0;
+  while (i < (sizeof(tests) / sizeof(*tests))) {
+    if (tests[i](tc) != 0) {
+      return -1;
+    }
+    ++i;
+  }
+  return 0;
+}
+
 int fetx_test(const char *const netlist_pathname,
               const char *const vector_pathname,
               unsigned long int multiply_driven, unsigned long int time_limit) {
@@ -126,6 +1381,44 @@ int fetx_test(const char *const netlist_pathname,
     return -1;
   }
 
+  /* simulate again, checking each row as it resolves */
+
+  struct fetx_sim_res check_res;
+  struct fetx_vector_check check = {.expected = correct_vec};
+  errs = fetx_vector_check(&check_res, &check, nl, input_vec, time_limit);
+  if (errs == FETX_ERR_MISMATCH) {
+    printf("Simulation failed (check): row %zu output %zu is %u, expected "
+           "%u\n",
+           check.row, check.output, check.actual,
+           correct_vec.values[check.row][check.output]);
+  } else if (errs != FETX_ERR_NONE) {
+    printf("Simulation failed (check): %u\n", errs);
+  } else if ((check_res.time != res.time) ||
+             (check_res.multiply_driven != res.multiply_driven)) {
+    puts("Simulation failed (check): results differ");
+    errs = FETX_ERR_PARAM;
+  }
+  if (errs != FETX_ERR_NONE) {
+    fetx_netlist_delete(nl);
+    fetx_vector_delete(output_vec);
+    fetx_vector_delete(vec);
+    fetx_vector_delete(correct_vec);
+    return -1;
+  }
+
+  const struct fetx_test_case tc = {.nl = nl,
+                                    .input_vec = input_vec,
+                                    .correct_vec = correct_vec,
+                                    .correct_res = res,
+                                    .time_limit = time_limit};
+  if (fetx_test_variants(&tc) != 0) {
+    fetx_netlist_delete(nl);
+    fetx_vector_delete(output_vec);
+    fetx_vector_delete(vec);
+    fetx_vector_delete(correct_vec);
+    return -1;
+  }
+
   printf("Test passed: %s %s\n", netlist_pathname, vector_pathname);
 
   /* clean up */